@@ -0,0 +1,574 @@
+/* file "tcfggen/lcubench.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+/* Description: Scaling benchmark of the TCFG construction and the emitters
+ *              on synthetic loop nests, from a few to many thousands of BBs.
+ *              The results are written as JSON and may be compared against
+ *              a baseline written by an earlier run. With -report the loop
+ *              nests are written as a loop report for lcudriver instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "tcfggen/lcuctx.h"
+#include "tcfggen/lcuinfo.h"
+#include "tcfggen/lcuemit.h"
+#include "tcfggen/lculog.h"
+
+
+void lcugen_read_loop_info(LcuContext *ctx, const LcuLoopInfo &nlinfo);
+void lcugen(LcuContext *ctx);
+
+
+// Measured quantities, reported as "<name>_ns" (best of the repetitions)
+enum {
+  M_READ = 0,                   // lcugen_read_loop_info
+  M_LCUGEN,                     // task formation, including the next two
+  M_GRAPH,                      // generate_graph, build_task_graph
+  M_TCFG,                       // generate_tcfg_entries
+  M_ENCODE,
+  M_EMIT_LUT,                   // one traversal per emitter
+  M_EMIT_VCG,
+  M_EMIT_FSM,
+  M_EMIT_CAC,
+  M_NUM
+};
+
+static const char *metric_names[M_NUM] = {
+  "read", "lcugen", "graph", "tcfg", "encode",
+  "emit_lut", "emit_vcg", "emit_fsm", "emit_cac"
+};
+
+// Shape of the synthetic loop nests
+struct bench_params {
+  unsigned depth;               // nesting depth of a nest
+  unsigned siblings;            // loops per nesting level
+  unsigned bbs;                 // BBs per task
+  unsigned unroll;              // innermost bodies have bbs*unroll BBs
+  unsigned reps;
+  unsigned micro_ms;            // -micro: minimum time per output measurement
+};
+
+struct bench_result {
+  unsigned size;                // requested BB count
+  unsigned bbs, tasks, edges, tcfg_entries;
+  unsigned long long ns[M_NUM];
+  unsigned long long bytes[LCU_ART_NUM];
+};
+
+
+/*
+ * Generator. A nest at depth d is a loop header, the body BBs, the nests of
+ * depth d+1 (each followed by a task of BBs at depth d) and the loop end,
+ * which is also the loop exit.
+ */
+static void gen_node(LcuLoopTable *t, unsigned *n, unsigned d, bool begin, bool end)
+{
+  t->set_node(*n, d, begin, end, end);
+  (*n)++;
+}
+
+static unsigned nest_size(const bench_params &p, unsigned d)
+{
+  unsigned body = (d == p.depth) ? p.bbs*p.unroll : p.bbs;
+  unsigned size = 1 + (body > 1 ? body-1 : 0) + 1;
+
+  if (d < p.depth)
+    size += p.siblings * (nest_size(p, d+1) + p.bbs);
+  return size;
+}
+
+static void gen_nest(LcuLoopTable *t, unsigned *n, const bench_params &p, unsigned d)
+{
+  unsigned body = (d == p.depth) ? p.bbs*p.unroll : p.bbs;
+  unsigned k, s;
+
+  gen_node(t, n, d, true, false);
+  for (k=1; k<body; k++)
+    gen_node(t, n, d, false, false);
+
+  if (d < p.depth)
+  {
+    for (s=0; s<p.siblings; s++)
+    {
+      gen_nest(t, n, p, d+1);
+      for (k=0; k<p.bbs; k++)
+        gen_node(t, n, d, false, false);
+    }
+  }
+
+  gen_node(t, n, d, false, true);
+}
+
+// Loop info of a procedure of exactly size BBs: entry, as many full nests as
+// fit, single loops in the remainder, straight-line BBs and the exit
+static void gen_procedure(LcuLoopTable *t, const bench_params &p, unsigned size)
+{
+  unsigned full = nest_size(p, 1) + p.bbs;
+  unsigned small = p.bbs*p.unroll + 1 + p.bbs;
+  unsigned n = 0, k;
+
+  t->clear();
+  t->set_name("bench", 5);
+  gen_node(t, &n, 0, false, false);
+
+  while (n + full + 1 <= size)
+  {
+    gen_nest(t, &n, p, 1);
+    for (k=0; k<p.bbs; k++)
+      gen_node(t, &n, 0, false, false);
+  }
+
+  while (n + small + 1 <= size)
+  {
+    gen_node(t, &n, 1, true, false);
+    for (k=1; k<p.bbs*p.unroll; k++)
+      gen_node(t, &n, 1, false, false);
+    gen_node(t, &n, 1, false, true);
+    for (k=0; k<p.bbs; k++)
+      gen_node(t, &n, 0, false, false);
+  }
+
+  while (n + 1 < size)
+    gen_node(t, &n, 0, false, false);
+  gen_node(t, &n, 0, false, false);
+}
+
+// The loop info of a procedure as a loop report entry (-report)
+static void write_report(LcuSink *out, const LcuLoopTable &t, unsigned size)
+{
+  unsigned n;
+
+  out->print("Procedure \"bench%u\":\n", size);
+  out->put("Loop info:\n");
+  out->put("  node depth begin end exit\n");
+  for (n=0; n<t.num_nodes(); n++)
+    out->print("%6u: %5d %5c %3c %4c\n", n, t.loop_depth(n),
+               t.is_loop_begin(n) ? 'Y' : 'N', t.is_loop_end(n) ? 'Y' : 'N',
+               t.is_loop_exit(n) ? 'Y' : 'N');
+}
+
+
+static void keep_min(unsigned long long *best, unsigned long long ns, unsigned rep)
+{
+  if (rep == 0 || ns < *best)
+    *best = ns;
+}
+
+static void emit_one(LcuContext *ctx, unsigned k, LcuSink *buf,
+                     unsigned long long *bytes)
+{
+  LcuLutEmitter lut(ctx, buf);
+  LcuVcgEmitter vcg(ctx, buf);
+  LcuFsmEmitter fsm(ctx, buf);
+  LcuCacEmitter cac(ctx, buf);
+  LcuEmitter *emitters[LCU_ART_NUM] = { &lut, &vcg, &fsm, &cac };
+
+  buf->open_memory();
+  lcu_emit(ctx, &emitters[k], 1);
+  *bytes = buf->get_size();
+  buf->close();
+}
+
+// Time of the encoding (k == -1) or of emitter k. In a -micro run the output
+// is repeated for at least min_ns, and the mean time of a run is returned.
+static unsigned long long time_output(LcuContext *ctx, int k, LcuSink *buf,
+                                      unsigned long long min_ns,
+                                      unsigned long long *bytes)
+{
+  unsigned long long t0 = lcu_now_ns();
+  unsigned long long elapsed, runs = 0;
+
+  do {
+    if (k < 0)
+      encode_tasks(ctx);
+    else
+      emit_one(ctx, k, buf, bytes);
+    runs++;
+    elapsed = lcu_now_ns() - t0;
+  } while (elapsed < min_ns);
+
+  return elapsed/runs;
+}
+
+static void run_size(LcuContext *ctx, LcuLoopTable *table, const bench_params &p,
+                     unsigned size, bench_result *r)
+{
+  LcuSink buf;
+  unsigned long long t0;
+  unsigned long long min_ns = p.micro_ms*1000000ULL;
+  unsigned rep, k;
+
+  gen_procedure(table, p, size);
+  memset(r, 0, sizeof(*r));
+  r->size = size;
+  r->bbs = table->num_nodes();
+
+  for (rep=0; rep<p.reps; rep++)
+  {
+    ctx->times.clear(NULL, -1);
+    ctx->reset(table->num_nodes());
+    ctx->set_proc_name(table->get_name());
+    ctx->reproducible = true;
+    ctx->lut_file_name = ctx->artifact_name(".lut");
+    ctx->vcg_file_name = ctx->artifact_name(".vcg");
+    ctx->fsm_file_name = ctx->artifact_name(".fsm");
+    ctx->cac_file_name = ctx->artifact_name(".cac");
+
+    t0 = lcu_now_ns();
+    lcugen_read_loop_info(ctx, *table);
+    keep_min(&r->ns[M_READ], lcu_now_ns() - t0, rep);
+
+    lcugen(ctx);
+    keep_min(&r->ns[M_LCUGEN], ctx->times.get_ns(LCU_PH_LCUGEN), rep);
+    keep_min(&r->ns[M_GRAPH], ctx->times.get_ns(LCU_PH_GRAPH), rep);
+    keep_min(&r->ns[M_TCFG], ctx->times.get_ns(LCU_PH_TCFG), rep);
+
+    keep_min(&r->ns[M_ENCODE], time_output(ctx, -1, &buf, min_ns, NULL), rep);
+
+    for (k=0; k<LCU_ART_NUM; k++)
+      keep_min(&r->ns[M_EMIT_LUT+k], time_output(ctx, k, &buf, min_ns, &r->bytes[k]), rep);
+  }
+
+  r->tasks = ctx->i_max;
+  r->edges = ctx->edge_list_max;
+  r->tcfg_entries = ctx->cac_task_id_max;
+}
+
+
+static double per_second(unsigned long long count, unsigned long long ns)
+{
+  return (ns > 0) ? count*1e9/ns : 0.0;
+}
+
+static void sprint_params(char *buf, const bench_params &p)
+{
+  sprintf(buf, "{\"depth\": %u, \"siblings\": %u, \"bbs_per_task\": %u, "
+          "\"unroll\": %u, \"reps\": %u, \"micro_ms\": %u}",
+          p.depth, p.siblings, p.bbs, p.unroll, p.reps, p.micro_ms);
+}
+
+static void write_json(LcuSink *out, const bench_params &p,
+                       const std::vector<bench_result> &results)
+{
+  char params[256];
+  unsigned i, m, k;
+
+  sprint_params(params, p);
+  out->put("{\n");
+  out->put("  \"tool\": \"lcubench\",\n");
+  out->print("  \"params\": %s,\n", params);
+  out->put("  \"results\": [\n");
+
+  // One result per line, which is what read_baseline() expects
+  for (i=0; i<results.size(); i++)
+  {
+    const bench_result &r = results[i];
+
+    out->print("    {\"size\": %u, \"bbs\": %u, \"tasks\": %u, \"edges\": %u, "
+               "\"tcfg_entries\": %u",
+               r.size, r.bbs, r.tasks, r.edges, r.tcfg_entries);
+    for (m=0; m<M_NUM; m++)
+      out->print(", \"%s_ns\": %llu", metric_names[m], r.ns[m]);
+    for (k=0; k<LCU_ART_NUM; k++)
+      out->print(", \"%s_bytes\": %llu", metric_names[M_EMIT_LUT+k], r.bytes[k]);
+
+    // Throughputs: tasks encoded, and bytes and task transitions (the
+    // entries of the LUT and the CAC table) emitted per second
+    out->print(", \"encode_entries_per_s\": %.0f", per_second(r.tasks, r.ns[M_ENCODE]));
+    for (k=0; k<LCU_ART_NUM; k++)
+      out->print(", \"%s_bytes_per_s\": %.0f, \"%s_entries_per_s\": %.0f",
+                 metric_names[M_EMIT_LUT+k], per_second(r.bytes[k], r.ns[M_EMIT_LUT+k]),
+                 metric_names[M_EMIT_LUT+k], per_second(r.edges, r.ns[M_EMIT_LUT+k]));
+    out->print("}%s\n", (i+1 < results.size()) ? "," : "");
+  }
+
+  out->put("  ]\n");
+  out->put("}\n");
+}
+
+// Value of "key": in a result line
+static bool get_value(const char *line, const char *key, unsigned long long *val)
+{
+  char pattern[64];
+  const char *p;
+
+  sprintf(pattern, "\"%s\": ", key);
+  p = strstr(line, pattern);
+  if (p == NULL)
+    return false;
+
+  *val = strtoull(p + strlen(pattern), NULL, 10);
+  return true;
+}
+
+// The results of a baseline file, and whether it was run with the same
+// loop nest parameters
+static bool read_baseline(const char *file_name, const bench_params &p,
+                          std::vector<bench_result> *results, bool *same_params)
+{
+  FILE *fp = fopen(file_name, "r");
+  char line[4096];
+  char key[64];
+  char params[256];
+
+  if (fp == NULL)
+    return false;
+
+  sprint_params(params, p);
+  *same_params = false;
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+  {
+    bench_result r;
+    unsigned long long v;
+    unsigned m, k;
+
+    if (strstr(line, "\"params\": ") != NULL && strstr(line, params) != NULL)
+      *same_params = true;
+
+    if (!get_value(line, "size", &v))
+      continue;
+
+    memset(&r, 0, sizeof(r));
+    r.size = v;
+    if (get_value(line, "bbs", &v))
+      r.bbs = v;
+    for (m=0; m<M_NUM; m++)
+    {
+      sprintf(key, "%s_ns", metric_names[m]);
+      get_value(line, key, &r.ns[m]);
+    }
+    for (k=0; k<LCU_ART_NUM; k++)
+    {
+      sprintf(key, "%s_bytes", metric_names[M_EMIT_LUT+k]);
+      get_value(line, key, &r.bytes[k]);
+    }
+    results->push_back(r);
+  }
+
+  fclose(fp);
+  return true;
+}
+
+// Report the measurements that got slower than the baseline by more than
+// threshold percent (and by more than min_ns, below which timer noise
+// dominates); returns their number
+static unsigned compare(const std::vector<bench_result> &results,
+                        const std::vector<bench_result> &baseline,
+                        double threshold, unsigned long long min_ns)
+{
+  unsigned regressions = 0;
+  unsigned i, j, m, k;
+
+  for (i=0; i<results.size(); i++)
+  {
+    const bench_result &r = results[i];
+
+    for (j=0; j<baseline.size(); j++)
+      if (baseline[j].size == r.size)
+        break;
+    if (j == baseline.size())
+    {
+      printf("size %u: not in the baseline\n", r.size);
+      continue;
+    }
+    const bench_result &b = baseline[j];
+
+    for (m=0; m<M_NUM; m++)
+    {
+      double change;
+
+      if (b.ns[m] == 0)
+        continue;
+      change = 100.0*((double)r.ns[m] - (double)b.ns[m])/b.ns[m];
+
+      if (change > threshold && r.ns[m] > b.ns[m] + min_ns)
+      {
+        printf("REGRESSION size %u %s: %.3f ms -> %.3f ms (%+.1f%%)\n",
+               r.size, metric_names[m], b.ns[m]/1e6, r.ns[m]/1e6, change);
+        regressions++;
+      }
+    }
+
+    for (k=0; k<LCU_ART_NUM; k++)
+      if (b.bytes[k] != 0 && b.bytes[k] != r.bytes[k])
+        printf("size %u %s: output size %llu -> %llu bytes\n",
+               r.size, metric_names[M_EMIT_LUT+k], b.bytes[k], r.bytes[k]);
+  }
+
+  return regressions;
+}
+
+
+static void print_usage()
+{
+  fprintf(stderr, "Usage: lcubench [options]\n");
+  fprintf(stderr, "  -sizes <n,n,...>   BB counts (default 10,100,1000,10000,100000)\n");
+  fprintf(stderr, "  -depth <d>         loop nesting depth (default 3)\n");
+  fprintf(stderr, "  -siblings <s>      loops per nesting level (default 2)\n");
+  fprintf(stderr, "  -bbs <b>           BBs per task (default 2)\n");
+  fprintf(stderr, "  -unroll <u>        innermost body size factor (default 1)\n");
+  fprintf(stderr, "  -reps <r>          repetitions, the best is kept (default 5)\n");
+  fprintf(stderr, "  -micro <ms>        repeat the encoding and every emitter for <ms>\n");
+  fprintf(stderr, "                     per repetition and take the mean time of a run\n");
+  fprintf(stderr, "  -o <file>          write the JSON results to <file> (default stdout)\n");
+  fprintf(stderr, "  -baseline <file>   compare against the results in <file>\n");
+  fprintf(stderr, "  -threshold <pct>   regression threshold (default 10)\n");
+  fprintf(stderr, "  -report <file>     write the loop nests as a loop report to <file>\n");
+  fprintf(stderr, "                     (one procedure per size) and time nothing\n");
+  fprintf(stderr, "  -v <level>         diagnostics level (0-4, default 1)\n");
+}
+
+int main(int argc, char **argv)
+{
+  bench_params p;
+  const char *sizes = "10,100,1000,10000,100000";
+  const char *out_file = NULL, *baseline_file = NULL, *report_file = NULL;
+  double threshold = 10.0;
+  std::vector<bench_result> results, baseline;
+  LcuContext ctx;
+  LcuLoopTable table;
+  LcuSink out, report;
+  const char *s;
+  int a;
+
+  p.depth = 3;
+  p.siblings = 2;
+  p.bbs = 2;
+  p.unroll = 1;
+  p.reps = 5;
+  p.micro_ms = 0;
+
+  for (a=1; a<argc; a++)
+  {
+    if (strcmp(argv[a], "-sizes") == 0 && a+1 < argc)
+      sizes = argv[++a];
+    else if (strcmp(argv[a], "-depth") == 0 && a+1 < argc)
+      p.depth = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-siblings") == 0 && a+1 < argc)
+      p.siblings = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-bbs") == 0 && a+1 < argc)
+      p.bbs = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-unroll") == 0 && a+1 < argc)
+      p.unroll = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-reps") == 0 && a+1 < argc)
+      p.reps = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-micro") == 0 && a+1 < argc)
+      p.micro_ms = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-o") == 0 && a+1 < argc)
+      out_file = argv[++a];
+    else if (strcmp(argv[a], "-baseline") == 0 && a+1 < argc)
+      baseline_file = argv[++a];
+    else if (strcmp(argv[a], "-threshold") == 0 && a+1 < argc)
+      threshold = atof(argv[++a]);
+    else if (strcmp(argv[a], "-report") == 0 && a+1 < argc)
+      report_file = argv[++a];
+    else if (strcmp(argv[a], "-v") == 0 && a+1 < argc)
+      lcu_log_set_level(atoi(argv[++a]));
+    else
+    {
+      print_usage();
+      return 1;
+    }
+  }
+
+  if (p.depth < 1 || p.siblings < 1 || p.bbs < 1 || p.unroll < 1 || p.reps < 1)
+  {
+    fprintf(stderr, "Error! -depth, -siblings, -bbs, -unroll and -reps must be at least 1.\n");
+    return 1;
+  }
+
+  if (report_file != NULL && !report.open(report_file))
+  {
+    fprintf(stderr, "Error! Can not open output file %s.\n", report_file);
+    return 1;
+  }
+
+  for (s=sizes; *s != '\0'; )
+  {
+    bench_result r;
+    unsigned size = strtoul(s, (char **)&s, 10);
+
+    if (size < 2)
+    {
+      fprintf(stderr, "Error! Bad -sizes list %s.\n", sizes);
+      return 1;
+    }
+
+    if (report.is_open())
+    {
+      gen_procedure(&table, p, size);
+      write_report(&report, table, size);
+    }
+    else
+    {
+      run_size(&ctx, &table, p, size, &r);
+      results.push_back(r);
+      lcu_log(LCU_LOG_INFO, "size %u: %u BBs, %u tasks, lcugen %.3f ms\n",
+              size, r.bbs, r.tasks, r.ns[M_LCUGEN]/1e6);
+    }
+
+    if (*s == ',')
+      s++;
+    else if (*s != '\0')
+    {
+      fprintf(stderr, "Error! Bad -sizes list %s.\n", sizes);
+      return 1;
+    }
+  }
+
+  if (report.is_open())
+  {
+    report.close();
+    return 0;
+  }
+
+  if (out_file != NULL)
+  {
+    if (!out.open(out_file))
+    {
+      fprintf(stderr, "Error! Can not open output file %s.\n", out_file);
+      return 1;
+    }
+    write_json(&out, p, results);
+    out.close();
+  }
+  else
+  {
+    out.open_memory();
+    write_json(&out, p, results);
+    fwrite(out.get_data(), 1, out.get_size(), stdout);
+    out.close();
+  }
+
+  if (baseline_file != NULL)
+  {
+    bool same_params;
+
+    if (!read_baseline(baseline_file, p, &baseline, &same_params))
+    {
+      fprintf(stderr, "Error! Can not read baseline %s.\n", baseline_file);
+      return 1;
+    }
+    if (!same_params)
+      lcu_log(LCU_LOG_WARN, "baseline %s was run with other loop nest parameters\n",
+              baseline_file);
+    if (compare(results, baseline, threshold, 20000) > 0)
+      return 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,321 @@
+/* file "tcfggen/lcubundle.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <algorithm>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcubundle.h"
+#endif
+
+#include "tcfggen/lcubundle.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+#define BUNDLE_MAGIC        "LCUBNDL"
+#define BUNDLE_INDEX_MAGIC  "LCUBIDX"
+#define BUNDLE_HEADER_SIZE  16
+#define BUNDLE_TRAILER_SIZE 24
+
+
+static const char *artifact_suffix[LCU_ART_NUM] = {
+  ".lut", ".vcg", ".fsm", ".cac"
+};
+
+const char *lcu_artifact_suffix(int kind)
+{
+  if (kind < 0 || kind >= LCU_ART_NUM)
+    return NULL;
+  return artifact_suffix[kind];
+}
+
+int lcu_artifact_kind_of(const char *suffix)
+{
+  int k;
+
+  if (suffix[0] == '.')
+    suffix++;
+
+  for (k=0; k<LCU_ART_NUM; k++)
+    if (strcmp(suffix, artifact_suffix[k]+1) == 0)
+      return k;
+
+  return -1;
+}
+
+static void put_u32(FILE *fp, unsigned long v)
+{
+  unsigned char b[4];
+  int i;
+
+  for (i=0; i<4; i++)
+    b[i] = (unsigned char)(v >> (8*i));
+  fwrite(b, 1, 4, fp);
+}
+
+static void put_u64(FILE *fp, unsigned long long v)
+{
+  unsigned char b[8];
+  int i;
+
+  for (i=0; i<8; i++)
+    b[i] = (unsigned char)(v >> (8*i));
+  fwrite(b, 1, 8, fp);
+}
+
+static unsigned long get_u32(const unsigned char *b)
+{
+  return (unsigned long)b[0] | ((unsigned long)b[1] << 8) |
+         ((unsigned long)b[2] << 16) | ((unsigned long)b[3] << 24);
+}
+
+static unsigned long long get_u64(const unsigned char *b)
+{
+  return (unsigned long long)get_u32(b) |
+         ((unsigned long long)get_u32(b+4) << 32);
+}
+
+
+LcuBundleWriter::LcuBundleWriter()
+{
+  fp = NULL;
+  data_end = 0;
+}
+
+LcuBundleWriter::~LcuBundleWriter()
+{
+  close();
+}
+
+bool LcuBundleWriter::open(const char *file_name)
+{
+  close();
+
+  fp = fopen(file_name, "wb");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "Error! Can not open bundle file %s.\n", file_name);
+    return false;
+  }
+
+  fwrite(BUNDLE_MAGIC, 1, 8, fp);
+  put_u32(fp, LCU_BUNDLE_VERSION);
+  put_u32(fp, 0);
+
+  data_end = BUNDLE_HEADER_SIZE;
+  entries.clear();
+
+  return true;
+}
+
+void LcuBundleWriter::add(const char *proc_name, int kind, const char *data, size_t size)
+{
+  lcu_bundle_entry e;
+
+  if (fp == NULL)
+    return;
+
+  e.proc_name = proc_name;
+  e.kind = kind;
+  e.offset = data_end;
+  e.size = size;
+  entries.push_back(e);
+
+  if (size > 0)
+    fwrite(data, 1, size, fp);
+  data_end += size;
+}
+
+void LcuBundleWriter::close()
+{
+  unsigned i;
+
+  if (fp == NULL)
+    return;
+
+  for (i=0; i<entries.size(); i++)
+  {
+    put_u32(fp, entries[i].kind);
+    put_u32(fp, entries[i].proc_name.size());
+    put_u64(fp, entries[i].offset);
+    put_u64(fp, entries[i].size);
+    fwrite(entries[i].proc_name.data(), 1, entries[i].proc_name.size(), fp);
+  }
+
+  put_u64(fp, data_end);
+  put_u32(fp, entries.size());
+  put_u32(fp, LCU_BUNDLE_VERSION);
+  fwrite(BUNDLE_INDEX_MAGIC, 1, 8, fp);
+
+  fclose(fp);
+  fp = NULL;
+  entries.clear();
+}
+
+
+static bool entry_less(const lcu_bundle_entry &a, const lcu_bundle_entry &b)
+{
+  int c = a.proc_name.compare(b.proc_name);
+
+  if (c != 0)
+    return c < 0;
+  return a.kind < b.kind;
+}
+
+LcuBundleReader::LcuBundleReader()
+{
+  fp = NULL;
+}
+
+LcuBundleReader::~LcuBundleReader()
+{
+  close();
+}
+
+bool LcuBundleReader::open(const char *file_name)
+{
+  unsigned char trailer[BUNDLE_TRAILER_SIZE];
+  unsigned char hdr[24];
+  unsigned long long index_offset;
+  unsigned long count, i;
+  off_t file_size;
+
+  close();
+
+  fp = fopen(file_name, "rb");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "Error! Can not open bundle file %s.\n", file_name);
+    return false;
+  }
+
+  if (fseeko(fp, 0, SEEK_END) != 0 ||
+      (file_size = ftello(fp)) < BUNDLE_HEADER_SIZE + BUNDLE_TRAILER_SIZE ||
+      fseeko(fp, file_size - BUNDLE_TRAILER_SIZE, SEEK_SET) != 0 ||
+      fread(trailer, 1, BUNDLE_TRAILER_SIZE, fp) != BUNDLE_TRAILER_SIZE ||
+      memcmp(trailer+16, BUNDLE_INDEX_MAGIC, 8) != 0)
+  {
+    fprintf(stderr, "Error! %s is not a complete artifact bundle.\n", file_name);
+    close();
+    return false;
+  }
+
+  if (get_u32(trailer+12) != LCU_BUNDLE_VERSION)
+  {
+    fprintf(stderr, "Error! Unsupported bundle version %lu in %s.\n",
+            get_u32(trailer+12), file_name);
+    close();
+    return false;
+  }
+
+  index_offset = get_u64(trailer);
+  count = get_u32(trailer+8);
+
+  if (fseeko(fp, (off_t)index_offset, SEEK_SET) != 0)
+  {
+    fprintf(stderr, "Error! Bad index offset in bundle %s.\n", file_name);
+    close();
+    return false;
+  }
+
+  for (i=0; i<count; i++)
+  {
+    lcu_bundle_entry e;
+    unsigned long name_len;
+
+    if (fread(hdr, 1, 24, fp) != 24)
+      break;
+
+    // An unknown kind (a damaged or a newer bundle) has no file suffix
+    if (get_u32(hdr) >= LCU_ART_NUM)
+      break;
+
+    e.kind = get_u32(hdr);
+    name_len = get_u32(hdr+4);
+    e.offset = get_u64(hdr+8);
+    e.size = get_u64(hdr+16);
+
+    if (name_len > (unsigned long long)file_size ||
+        e.offset + e.size > index_offset)
+      break;
+
+    e.proc_name.resize(name_len);
+    if (name_len > 0 && fread(&e.proc_name[0], 1, name_len, fp) != name_len)
+      break;
+
+    entries.push_back(e);
+  }
+
+  if (entries.size() != count)
+  {
+    fprintf(stderr, "Error! Corrupt index in bundle %s.\n", file_name);
+    close();
+    return false;
+  }
+
+  std::stable_sort(entries.begin(), entries.end(), entry_less);
+
+  return true;
+}
+
+void LcuBundleReader::close()
+{
+  if (fp != NULL)
+    fclose(fp);
+  fp = NULL;
+  entries.clear();
+}
+
+int LcuBundleReader::find(const char *proc_name, int kind) const
+{
+  lcu_bundle_entry key;
+  std::vector<lcu_bundle_entry>::const_iterator it;
+
+  key.proc_name = proc_name;
+  key.kind = kind;
+
+  it = std::lower_bound(entries.begin(), entries.end(), key, entry_less);
+  if (it == entries.end() || it->proc_name != key.proc_name || it->kind != kind)
+    return -1;
+
+  return it - entries.begin();
+}
+
+bool LcuBundleReader::extract(unsigned i, FILE *outfile)
+{
+  char buf[64*1024];
+  unsigned long long left;
+
+  if (fp == NULL || i >= entries.size() ||
+      fseeko(fp, (off_t)entries[i].offset, SEEK_SET) != 0)
+    return false;
+
+  left = entries[i].size;
+  while (left > 0)
+  {
+    size_t n = (left < sizeof(buf)) ? (size_t)left : sizeof(buf);
+
+    if (fread(buf, 1, n, fp) != n)
+      return false;
+    fwrite(buf, 1, n, outfile);
+    left -= n;
+  }
+
+  return true;
+}
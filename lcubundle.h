@@ -0,0 +1,111 @@
+/* file "tcfggen/lcubundle.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUBUNDLE_H
+#define TCFGGEN_LCUBUNDLE_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcubundle.h"
+#endif
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+
+/*
+ * Artifact bundle = single container file for the artifacts of all the
+ * procedures of a run (-bundle). Layout, all integers little-endian:
+ *
+ *   header   "LCUBNDL\0", u32 version, u32 reserved
+ *   data     artifact contents, back to back
+ *   index    one entry per artifact:
+ *              u32 kind, u32 name length, u64 offset, u64 size, name bytes
+ *   trailer  u64 index offset, u32 entry count, u32 version, "LCUBIDX\0"
+ *
+ * The index is written last, so a bundle is only valid once its writer has
+ * been closed.
+ */
+
+#define LCU_BUNDLE_VERSION  1
+
+enum lcu_artifact_kind {
+  LCU_ART_LUT = 0,
+  LCU_ART_VCG,
+  LCU_ART_FSM,
+  LCU_ART_CAC,
+  LCU_ART_NUM
+};
+
+// File name suffix of an artifact kind (e.g. ".lut"), or NULL
+const char *lcu_artifact_suffix(int kind);
+
+// Artifact kind for a name suffix with or without the dot, or -1
+int lcu_artifact_kind_of(const char *suffix);
+
+struct lcu_bundle_entry {
+  std::string proc_name;
+  int kind;
+  unsigned long long offset;
+  unsigned long long size;
+};
+
+class LcuBundleWriter {
+  public:
+    LcuBundleWriter();
+    ~LcuBundleWriter();
+
+    bool open(const char *file_name);
+    void add(const char *proc_name, int kind, const char *data, size_t size);
+    void close();                       // writes the index
+    bool is_open() const                { return fp != NULL; }
+
+  protected:
+    FILE *fp;
+    unsigned long long data_end;
+    std::vector<lcu_bundle_entry> entries;
+
+  private:
+    LcuBundleWriter(const LcuBundleWriter&);
+    LcuBundleWriter& operator=(const LcuBundleWriter&);
+};
+
+class LcuBundleReader {
+  public:
+    LcuBundleReader();
+    ~LcuBundleReader();
+
+    // Read the index; false (with a message on stderr) for a bad bundle
+    bool open(const char *file_name);
+    void close();
+
+    unsigned size() const               { return entries.size(); }
+    const lcu_bundle_entry &get_entry(unsigned i) const { return entries[i]; }
+
+    // Entry number of an artifact, or -1 (binary search on the index)
+    int find(const char *proc_name, int kind) const;
+
+    // Copy the contents of entry i to outfile
+    bool extract(unsigned i, FILE *outfile);
+
+  protected:
+    FILE *fp;
+    std::vector<lcu_bundle_entry> entries;    // sorted by name, then kind
+
+  private:
+    LcuBundleReader(const LcuBundleReader&);
+    LcuBundleReader& operator=(const LcuBundleReader&);
+};
+
+
+#endif /* TCFGGEN_LCUBUNDLE_H */
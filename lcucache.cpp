@@ -0,0 +1,195 @@
+/* file "tcfggen/lcucache.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcucache.h"
+#endif
+
+#include "tcfggen/lcucache.h"
+#include "tcfggen/lcuside.h"
+#include "tcfggen/lculog.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+
+LcuAnalysisCache::LcuAnalysisCache()
+{
+  dir = NULL;
+  hits = misses = damaged = 0;
+  stores = store_errors = 0;
+}
+
+LcuAnalysisCache::~LcuAnalysisCache()
+{
+  close();
+}
+
+bool LcuAnalysisCache::open(const char *dir_name)
+{
+  struct stat st;
+
+  close();
+
+  if (mkdir(dir_name, 0777) != 0 && errno != EEXIST)
+  {
+    lcu_log(LCU_LOG_ERROR, "Can not create cache directory %s\n", dir_name);
+    return false;
+  }
+  if (stat(dir_name, &st) != 0 || !S_ISDIR(st.st_mode))
+  {
+    lcu_log(LCU_LOG_ERROR, "%s is not a directory\n", dir_name);
+    return false;
+  }
+
+  dir = strdup(dir_name);
+  hits = misses = damaged = 0;
+  stores = store_errors = 0;
+
+  return true;
+}
+
+void LcuAnalysisCache::close()
+{
+  free(dir);
+  dir = NULL;
+}
+
+// malloc'ed "<dir>/<key><suffix>"
+char *LcuAnalysisCache::entry_name(unsigned long long key, const char *suffix)
+{
+  char *name = (char *)malloc(strlen(dir) + strlen(suffix) + 32);
+
+  sprintf(name, "%s/%016llx%s", dir, key, suffix);
+  return name;
+}
+
+bool LcuAnalysisCache::lookup(unsigned long long key, unsigned num_nodes,
+                              unsigned num_cfg_edges, LcuContext *ctx)
+{
+  LcuSidecarReader entry;
+  char *name = entry_name(key, ".side");
+  bool found = false;
+
+  if (access(name, R_OK) != 0)
+  {
+    misses++;
+    free(name);
+    return false;
+  }
+
+  // An entry of another format version is not damaged, just out of date;
+  // it is replaced by the store of this unit
+  if (LcuSidecarReader::file_version(name) != LCU_SIDE_VERSION)
+  {
+    lcu_log(LCU_LOG_DEBUG, "Cache entry %s has another format version\n",
+            name);
+    misses++;
+    free(name);
+    return false;
+  }
+
+  if (!entry.open(name) || entry.num_units() != 1)
+  {
+    lcu_log(LCU_LOG_WARN, "Ignoring the damaged cache entry %s\n", name);
+    damaged++;
+  }
+  else if (entry.get_unit(0).num_nodes != num_nodes ||
+           entry.get_unit(0).num_cfg_edges != num_cfg_edges)
+  {
+    // Another CFG with the same hash
+    lcu_log(LCU_LOG_DEBUG, "Cache entry %s is for another CFG\n", name);
+  }
+  else
+  {
+    // The name is not part of the key: the entry may have been made for a
+    // procedure of another name, whose name is ignored
+    char *proc_name = strdup(ctx->proc_name);
+
+    entry.load_unit(0, ctx);
+    ctx->set_proc_name(proc_name);
+    ctx->cache_key = key;
+    ctx->cached = true;
+    free(proc_name);
+    found = true;
+  }
+
+  entry.close();
+  free(name);
+
+  if (found)
+    hits++;
+  else
+    misses++;
+  return found;
+}
+
+void LcuAnalysisCache::store(LcuContext *ctx)
+{
+  LcuSidecarWriter writer;
+  char suffix[32];
+  char *tmp_name, *name;
+
+  if (dir == NULL || ctx->cached)
+    return;
+
+  // Unique among the runs that share the directory
+  sprintf(suffix, ".%ld.tmp", (long)getpid());
+  tmp_name = entry_name(ctx->cache_key, suffix);
+  name = entry_name(ctx->cache_key, ".side");
+
+  if (writer.open(tmp_name))
+  {
+    writer.add(ctx);
+    writer.close();
+
+    if (rename(tmp_name, name) == 0)
+      stores++;
+    else
+    {
+      lcu_log(LCU_LOG_WARN, "Can not store the cache entry %s\n", name);
+      remove(tmp_name);
+      store_errors++;
+    }
+  }
+  else
+    store_errors++;
+
+  free(tmp_name);
+  free(name);
+}
+
+void LcuAnalysisCache::print_stats(LcuSink *out, bool compact) const
+{
+  unsigned lookups = hits + misses;
+  double hit_rate = (lookups > 0) ? 100.0*hits/lookups : 0.0;
+
+  if (compact)
+    out->print("cache hits=%u misses=%u damaged=%u stores=%u store_errors=%u "
+               "hit_rate=%.1f\n",
+               hits, misses, damaged, stores, store_errors, hit_rate);
+  else
+    out->print("Analysis cache: %u hits, %u misses (%u damaged entries), "
+               "%u entries stored (%u failed), hit rate %.1f%%\n",
+               hits, misses, damaged, stores, store_errors, hit_rate);
+}
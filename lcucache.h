@@ -0,0 +1,68 @@
+/* file "tcfggen/lcucache.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUCACHE_H
+#define TCFGGEN_LCUCACHE_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcucache.h"
+#endif
+
+#include "tcfggen/lcuctx.h"
+#include "tcfggen/lcusink.h"
+
+
+/*
+ * Analysis cache = directory of the analysis results of earlier runs, keyed
+ * by a structural hash of the CFG (-cache_dir). Each entry is a sidecar file
+ * (lcuside.h) of a single unit, named "<hash>.side" after the 16 hex digits
+ * of the key. Entries are written to a temporary file and renamed, so runs
+ * sharing a directory never see a partial one. A damaged entry, or one of
+ * another sidecar version, counts as a miss and is replaced.
+ */
+class LcuAnalysisCache {
+  public:
+    LcuAnalysisCache();
+    ~LcuAnalysisCache();
+
+    // Use the given directory, creating it if needed
+    bool open(const char *dir_name);
+    void close();
+    bool is_open() const                { return dir != NULL; }
+
+    // Restore the tables of the unit with the given key into ctx (reset
+    // first); false on a miss. An entry only matches a CFG of the same node
+    // and edge counts. The name of ctx is kept: the key does not cover it.
+    bool lookup(unsigned long long key, unsigned num_nodes,
+                unsigned num_cfg_edges, LcuContext *ctx);
+
+    // Record the tables of an analyzed unit under ctx->cache_key
+    void store(LcuContext *ctx);
+
+    // Statistics of the run, as a line of the loop report
+    void print_stats(LcuSink *out, bool compact) const;
+
+  protected:
+    char *entry_name(unsigned long long key, const char *suffix);
+
+    char *dir;
+    unsigned hits, misses, damaged;
+    unsigned stores, store_errors;
+
+  private:
+    LcuAnalysisCache(const LcuAnalysisCache&);
+    LcuAnalysisCache& operator=(const LcuAnalysisCache&);
+};
+
+
+#endif /* TCFGGEN_LCUCACHE_H */
@@ -0,0 +1,212 @@
+/* file "tcfggen/lcuctx.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcuctx.h"
+#endif
+
+#include "tcfggen/lcuctx.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+#define ARENA_ALIGN  16
+
+
+LcuArena::LcuArena(size_t chunk_size_in)
+{
+  first_chunk = NULL;
+  cur_chunk = NULL;
+  chunk_size = chunk_size_in;
+}
+
+LcuArena::~LcuArena()
+{
+  chunk_t *p = first_chunk;
+
+  while (p != NULL)
+  {
+    chunk_t *next = p->next;
+    free(p);
+    p = next;
+  }
+}
+
+void *LcuArena::alloc(size_t size)
+{
+  size_t hdr = (sizeof(chunk_t) + ARENA_ALIGN-1) & ~(size_t)(ARENA_ALIGN-1);
+
+  size = (size + ARENA_ALIGN-1) & ~(size_t)(ARENA_ALIGN-1);
+
+  // Look for room in the current chunk, or in the chunks retained by the
+  // last reset
+  while (cur_chunk != NULL && cur_chunk->used + size > cur_chunk->size)
+  {
+    if (cur_chunk->next == NULL)
+      break;
+    cur_chunk = cur_chunk->next;
+    cur_chunk->used = 0;
+  }
+
+  if (cur_chunk == NULL || cur_chunk->used + size > cur_chunk->size)
+  {
+    size_t csize = (size > chunk_size) ? size : chunk_size;
+    chunk_t *c = (chunk_t *)malloc(hdr + csize);
+
+    if (c == NULL)
+    {
+      fprintf(stderr, "Error! Out of memory in the lcugen arena.\n");
+      exit(1);
+    }
+
+    c->next = NULL;
+    c->size = csize;
+    c->used = 0;
+
+    if (cur_chunk == NULL)
+      first_chunk = c;
+    else
+    {
+      c->next = cur_chunk->next;
+      cur_chunk->next = c;
+    }
+    cur_chunk = c;
+  }
+
+  void *p = (char *)cur_chunk + hdr + cur_chunk->used;
+  cur_chunk->used += size;
+
+  return p;
+}
+
+void LcuArena::reset()
+{
+  cur_chunk = first_chunk;
+
+  if (cur_chunk != NULL)
+    cur_chunk->used = 0;
+}
+
+
+LcuContext::LcuContext()
+{
+  proc_name = NULL;
+  gen_lut_file = false;
+  gen_vcg_file = false;
+  gen_fsm_file = false;
+  gen_cac_file = false;
+  bundle_artifacts = false;
+  reproducible = false;
+  lut_file_name = NULL;
+  vcg_file_name = NULL;
+  fsm_file_name = NULL;
+  cac_file_name = NULL;
+  bb_pool = NULL;
+  enc_buf = NULL;
+  enc_buf_size = 0;
+  succ_start = NULL;
+  succ_edge = NULL;
+  num_nodes = 0;
+  num_cfg_edges = 0;
+  last_node_num = 0;
+  i_max = 0;
+  edge_list_max = 0;
+  cac_task_id_max = 0;
+  fwdsel_max = 0;
+  nlp = 0;
+  overhead_max = 0;
+  cache_key = 0;
+  cached = false;
+}
+
+void LcuContext::reset(unsigned num_nodes_in)
+{
+  unsigned n = num_nodes_in + 2;
+
+  arena.reset();
+
+  for (unsigned k=0; k<LCU_ART_NUM; k++)
+    artifact_buf[k].close();
+
+  num_nodes = num_nodes_in;
+  num_cfg_edges = 0;
+  last_node_num = 0;
+  proc_name = NULL;
+  lut_file_name = NULL;
+  vcg_file_name = NULL;
+  fsm_file_name = NULL;
+  cac_file_name = NULL;
+
+  node_num_arr.init(&arena, n);
+  loop_depth_arr.init(&arena, n);
+  node_begin_arr.init(&arena, n);
+  node_end_arr.init(&arena, n);
+  node_exit_arr.init(&arena, n);
+
+  // There can be no more tasks than BBs (plus the bwd0 task), each task
+  // contributes at most two edges and each edge at most two TCFG entries
+  task_data_arr.init(&arena, n);
+  bb_pool = (int *)arena.alloc(n*sizeof(int));
+  bb_task_arr.init(&arena, n);
+  task_enc_arr.init(&arena, n);
+  enc_buf = NULL;
+  enc_buf_size = 0;
+  edge_list.init(&arena, 2*n);
+  TCFG.init(&arena, 4*n);
+  succ_start = succ_edge = NULL;
+
+  // Loop overhead entries are usually four per loop at most, but the
+  // pattern matching (commit_unit) grows the table as it needs; loop
+  // addresses are bounded by the number of loop headers
+  LoopOverheadInstr.init(&arena, 4*n);
+  loop_index_arr.init(&arena, n);
+  loop_initial_arr.init(&arena, n);
+  loop_step_arr.init(&arena, n);
+  loop_final_arr.init(&arena, n);
+  is_looping_pattern_flag_arr.init(&arena, n);
+
+  i_max = 0;
+  edge_list_max = 0;
+  cac_task_id_max = 0;
+  fwdsel_max = 0;
+  nlp = 0;
+  overhead_max = 0;
+  cache_key = 0;
+  cached = false;
+}
+
+void LcuContext::set_proc_name(const char *name)
+{
+  size_t len = strlen(name);
+
+  proc_name = (char *)arena.alloc(len+1);
+  memcpy(proc_name, name, len+1);
+}
+
+char *LcuContext::artifact_name(const char *suffix)
+{
+  size_t len = strlen(proc_name);
+  size_t slen = strlen(suffix);
+  char *name = (char *)arena.alloc(len+slen+1);
+
+  memcpy(name, proc_name, len);
+  memcpy(name+len, suffix, slen+1);
+
+  return name;
+}
@@ -0,0 +1,232 @@
+/* file "tcfggen/lcuctx.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUCTX_H
+#define TCFGGEN_LCUCTX_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcuctx.h"
+#endif
+
+#include <stddef.h>
+#include <string.h>
+
+#include "tcfggen/lcugen.h"
+#include "tcfggen/lcusink.h"
+#include "tcfggen/lcubundle.h"
+#include "tcfggen/lcutime.h"
+#include "tcfggen/lculog.h"
+
+
+/*
+ * LcuArena = bump allocator for per-procedure scratch data.
+ * Chunks are retained by reset(), so once the arena has grown to fit the
+ * largest procedure seen so far, no further heap allocation takes place.
+ */
+class LcuArena {
+  public:
+    LcuArena(size_t chunk_size = 64*1024);
+    ~LcuArena();
+
+    void *alloc(size_t size);
+    void reset();
+
+  protected:
+    struct chunk_t {
+      chunk_t *next;
+      size_t   size;
+      size_t   used;
+    };
+
+    chunk_t *first_chunk;
+    chunk_t *cur_chunk;
+    size_t   chunk_size;
+
+  private:
+    LcuArena(const LcuArena&);
+    LcuArena& operator=(const LcuArena&);
+};
+
+/*
+ * LcuTable = table of plain-old-data entries, backed by an LcuArena. An index
+ * beyond the capacity is a bug and fails an lcu_claim(); code that needs
+ * more entries than the table was sized for (e.g. the look-ahead to
+ * task_data_arr[i+1] past the last task) asks for them with ensure(), and
+ * the new entries are zero-filled.
+ */
+template <class T>
+class LcuTable {
+  public:
+    LcuTable() : arena(NULL), data(NULL), capacity(0) { }
+
+    // Start a fresh, zero-filled table of the given capacity
+    void init(LcuArena *a, unsigned initial_capacity)
+    {
+      arena = a;
+      data = NULL;
+      capacity = 0;
+      grow(initial_capacity > 0 ? initial_capacity : 1);
+    }
+
+    T& operator[](unsigned i)
+    {
+      lcu_claim(i < capacity, "table index out of range");
+      return data[i];
+    }
+
+    // Make room for (at least) n entries
+    void ensure(unsigned n)
+    {
+      if (n > capacity)
+        grow(n);
+    }
+
+    unsigned get_capacity() const       { return capacity; }
+
+  protected:
+    void grow(unsigned min_capacity)
+    {
+      unsigned new_capacity = (capacity > 0) ? capacity : 16;
+
+      while (new_capacity < min_capacity)
+        new_capacity *= 2;
+
+      // The old storage is simply abandoned; it is reclaimed by the next
+      // arena reset.
+      T *new_data = (T *)arena->alloc(new_capacity*sizeof(T));
+      if (capacity > 0)
+        memcpy(new_data, data, capacity*sizeof(T));
+      memset(new_data+capacity, 0, (new_capacity-capacity)*sizeof(T));
+
+      data = new_data;
+      capacity = new_capacity;
+    }
+
+    LcuArena *arena;
+    T *data;
+    unsigned capacity;
+};
+
+/*
+ * LcuContext = per-procedure state of the TCFG construction.
+ * All tables are sized from the node count of the CFG under processing and
+ * live in a single arena, which is reset when the next procedure starts.
+ */
+class LcuContext {
+  public:
+    LcuContext();
+
+    // Prepare the context for a procedure with num_nodes CFG nodes
+    void reset(unsigned num_nodes);
+
+    // Copy the procedure name into the arena (call after reset)
+    void set_proc_name(const char *name);
+
+    // Arena-allocated "<proc_name><suffix>"
+    char *artifact_name(const char *suffix);
+
+    LcuArena arena;
+
+    // Procedure under processing and the artifacts requested for it
+    char *proc_name;
+    bool gen_lut_file, gen_vcg_file, gen_fsm_file, gen_cac_file;
+    char *lut_file_name, *vcg_file_name, *fsm_file_name, *cac_file_name;
+
+    // With bundle_artifacts set, the artifacts are rendered into
+    // artifact_buf (by kind) and stored in the bundle by the caller
+    bool bundle_artifacts;
+    LcuSink artifact_buf[LCU_ART_NUM];
+
+    // No timestamps in the artifacts; files are only rewritten on change
+    bool reproducible;
+
+    // Phase times of the unit. Cleared when the unit starts, not by reset(),
+    // since the CFG simplification is timed before the tables are sized.
+    LcuTimes times;
+
+    // Loop analysis results, indexed by CFG node number
+    LcuTable<unsigned> node_num_arr;
+    LcuTable<unsigned> loop_depth_arr;
+    LcuTable<unsigned> node_begin_arr;
+    LcuTable<unsigned> node_end_arr;
+    LcuTable<unsigned> node_exit_arr;
+
+    // Data processing tasks. The BB list of each task points into bb_pool,
+    // since every BB of the CFG belongs to exactly one task.
+    LcuTable<task_data> task_data_arr;
+    int *bb_pool;
+
+    // BB -> task index, built once the tasks are formed (-1: no task)
+    LcuTable<int> bb_task_arr;
+
+    int bb_task(unsigned bb_num)
+    {
+      return (bb_num <= last_node_num) ? bb_task_arr[bb_num] : -1;
+    }
+
+    // First and last BB of a task (-1 for a task without BBs)
+    int first_bb(unsigned i)
+    {
+      task_data &t = task_data_arr[i];
+      return (t.bb_list_size > 0) ? t.bb_list[0] : -1;
+    }
+    int last_bb(unsigned i)
+    {
+      task_data &t = task_data_arr[i];
+      return (t.bb_list_size > 0) ? t.bb_list[t.bb_list_size-1] : -1;
+    }
+
+    // Encodings of the tasks, computed once for all the artifacts. The
+    // strings live in enc_buf (arena), which a repeated encoding reuses.
+    LcuTable<task_enc> task_enc_arr;
+    char *enc_buf;
+    size_t enc_buf_size;
+
+    // Task graph edges and the resulting TCFG entries
+    LcuTable<task_edge> edge_list;
+    LcuTable<tcfg_edge> TCFG;
+
+    // Task graph adjacency in compressed sparse row form, built from
+    // edge_list by build_task_graph(). The out-edges of task t are
+    // succ_edge[succ_start[t] .. succ_start[t+1]-1] (edge_list indices, in
+    // edge_list order).
+    unsigned *succ_start, *succ_edge;
+
+    unsigned succ_begin(unsigned t) const { return succ_start[t]; }
+    unsigned succ_end(unsigned t) const   { return succ_start[t+1]; }
+
+    // Loop overhead instructions and loop parameters (by loop address)
+    LcuTable<cfg_instr_pos> LoopOverheadInstr;
+    LcuTable<int> loop_index_arr;
+    LcuTable<int> loop_initial_arr;
+    LcuTable<int> loop_step_arr;
+    LcuTable<int> loop_final_arr;
+    LcuTable<bool> is_looping_pattern_flag_arr;
+
+    unsigned num_nodes;
+    unsigned num_cfg_edges;        // CFG edges (0 when unknown)
+    unsigned last_node_num;        // highest CFG node number
+    unsigned i_max;                // number of tasks
+    unsigned edge_list_max;        // number of unique task transition entries
+    unsigned cac_task_id_max;      // number of (redundant) task transition entries
+    unsigned fwdsel_max, nlp;
+    unsigned overhead_max;         // number of loop overhead entries
+
+    // Analysis cache (-cache_dir): structural hash of the CFG of the unit,
+    // and whether the tables above were restored from the cache
+    unsigned long long cache_key;
+    bool cached;
+};
+
+
+#endif /* TCFGGEN_LCUCTX_H */
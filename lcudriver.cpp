@@ -0,0 +1,241 @@
+/* file "tcfggen/lcudriver.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+/* Description: Builds the TCFG and the artifacts of the procedures in loop
+ *              analysis reports, without MachSUIF. The reports are the
+ *              loop_results.txt files of "do_tcfggen -report full", or any
+ *              file with "Loop info:" tables in the same format. Sidecar
+ *              files (-sidecar) are re-emitted as they are, without the
+ *              TCFG construction.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcfggen/lcuctx.h"
+#include "tcfggen/lcuinfo.h"
+#include "tcfggen/lcubundle.h"
+#include "tcfggen/lcuside.h"
+#include "tcfggen/lculog.h"
+
+
+void lcugen_read_loop_info(LcuContext *ctx, const LcuLoopInfo &nlinfo);
+void lcugen(LcuContext *ctx);
+void lcugen_emit(LcuContext *ctx);
+
+
+static void print_usage()
+{
+  fprintf(stderr, "Usage: lcudriver [options] <report or sidecar> ...\n");
+  fprintf(stderr, "  -lut, -vcg, -fsm, -cac\n");
+  fprintf(stderr, "                 artifacts to generate (default: all)\n");
+  fprintf(stderr, "  -reproducible  no timestamps; files are only rewritten on change\n");
+  fprintf(stderr, "  -bundle <file> store the artifacts in a bundle\n");
+  fprintf(stderr, "  -sidecar <file>\n");
+  fprintf(stderr, "                 write the TCFG of the procedures to a sidecar\n");
+  fprintf(stderr, "  -times         print the phase times (ms) of each procedure\n");
+  fprintf(stderr, "  -v <level>     diagnostics level (0-4, default 1)\n");
+}
+
+// Move the artifacts rendered for a unit into the bundle
+static void store_artifacts(LcuContext *ctx, LcuBundleWriter *bundle)
+{
+  for (int k=0; k<LCU_ART_NUM; k++)
+  {
+    LcuSink *buf = &ctx->artifact_buf[k];
+
+    if (buf->is_open())
+    {
+      bundle->add(ctx->proc_name, k, buf->get_data(), buf->get_size());
+      buf->close();
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  LcuContext ctx;
+  LcuLoopReport report;
+  LcuLoopTable table;
+  LcuBundleWriter bundle;
+  LcuSidecarWriter sidecar;
+  LcuSidecarReader side_in;
+  LcuTimes run_times;
+  LcuSink times_out;             // -times text, written at the end
+  bool gen_lut = false, gen_vcg = false, gen_fsm = false, gen_cac = false;
+  bool reproducible = false, print_times = false;
+  const char *bundle_file = NULL;
+  const char *sidecar_file = NULL;
+  unsigned num_units = 0;
+  int errors = 0;
+  int a;
+
+  for (a=1; a<argc && argv[a][0] == '-'; a++)
+  {
+    if (strcmp(argv[a], "-lut") == 0)
+      gen_lut = true;
+    else if (strcmp(argv[a], "-vcg") == 0)
+      gen_vcg = true;
+    else if (strcmp(argv[a], "-fsm") == 0)
+      gen_fsm = true;
+    else if (strcmp(argv[a], "-cac") == 0)
+      gen_cac = true;
+    else if (strcmp(argv[a], "-reproducible") == 0)
+      reproducible = true;
+    else if (strcmp(argv[a], "-times") == 0)
+      print_times = true;
+    else if (strcmp(argv[a], "-bundle") == 0 && a+1 < argc)
+      bundle_file = argv[++a];
+    else if (strcmp(argv[a], "-sidecar") == 0 && a+1 < argc)
+      sidecar_file = argv[++a];
+    else if (strcmp(argv[a], "-v") == 0 && a+1 < argc)
+      lcu_log_set_level(atoi(argv[++a]));
+    else
+    {
+      print_usage();
+      return 1;
+    }
+  }
+
+  if (a >= argc)
+  {
+    print_usage();
+    return 1;
+  }
+
+  if (!gen_lut && !gen_vcg && !gen_fsm && !gen_cac)
+    gen_lut = gen_vcg = gen_fsm = gen_cac = true;
+
+  if (bundle_file != NULL && !bundle.open(bundle_file))
+  {
+    fprintf(stderr, "Error! Can not open bundle file %s.\n", bundle_file);
+    return 1;
+  }
+
+  if (sidecar_file != NULL && !sidecar.open(sidecar_file))
+    return 1;
+
+  if (print_times)
+    times_out.open_memory();
+
+  for (; a<argc; a++)
+  {
+    // A sidecar holds the finished tables; only the emission is left
+    if (LcuSidecarReader::is_sidecar(argv[a]))
+    {
+      if (!side_in.open(argv[a]))
+      {
+        errors++;
+        continue;
+      }
+
+      for (unsigned u=0; u<side_in.num_units(); u++)
+      {
+        lcu_log(LCU_LOG_INFO, "Emitting CFG \"%s\"\n", side_in.get_name(u));
+
+        ctx.times.clear(NULL, -1);
+        side_in.load_unit(u, &ctx);
+        ctx.gen_lut_file = gen_lut;
+        ctx.gen_vcg_file = gen_vcg;
+        ctx.gen_fsm_file = gen_fsm;
+        ctx.gen_cac_file = gen_cac;
+        ctx.bundle_artifacts = bundle.is_open();
+        ctx.reproducible = reproducible;
+
+        lcugen_emit(&ctx);
+
+        if (ctx.bundle_artifacts)
+          store_artifacts(&ctx, &bundle);
+        if (sidecar.is_open())
+          sidecar.add(&ctx);
+
+        if (print_times)
+        {
+          times_out.print("%s: ", ctx.proc_name);
+          ctx.times.print(&times_out);
+          times_out.put("\n");
+        }
+        run_times.add(ctx.times);
+        num_units++;
+      }
+
+      side_in.close();
+      continue;
+    }
+
+    if (!report.open(argv[a]))
+    {
+      fprintf(stderr, "Error! Can not read loop report %s.\n", argv[a]);
+      errors++;
+      continue;
+    }
+
+    while (report.next_unit(&table))
+    {
+      if (table.num_nodes() == 0)
+      {
+        lcu_log(LCU_LOG_ERROR, "%s:%u: empty loop info table\n",
+                argv[a], report.get_line());
+        errors++;
+        continue;
+      }
+
+      lcu_log(LCU_LOG_INFO, "Processing CFG \"%s\"\n", table.get_name());
+
+      ctx.times.clear(NULL, -1);
+      ctx.reset(table.num_nodes());
+      ctx.set_proc_name(table.get_name());
+      ctx.gen_lut_file = gen_lut;
+      ctx.gen_vcg_file = gen_vcg;
+      ctx.gen_fsm_file = gen_fsm;
+      ctx.gen_cac_file = gen_cac;
+      ctx.bundle_artifacts = bundle.is_open();
+      ctx.reproducible = reproducible;
+
+      lcugen_read_loop_info(&ctx, table);
+      lcugen(&ctx);
+      lcugen_emit(&ctx);
+
+      if (ctx.bundle_artifacts)
+        store_artifacts(&ctx, &bundle);
+      if (sidecar.is_open())
+        sidecar.add(&ctx);
+
+      if (print_times)
+      {
+        times_out.print("%s: ", ctx.proc_name);
+        ctx.times.print(&times_out);
+        times_out.put("\n");
+      }
+      run_times.add(ctx.times);
+      num_units++;
+    }
+
+    report.close();
+  }
+
+  if (print_times)
+  {
+    times_out.print("%u procedures: ", num_units);
+    run_times.print(&times_out);
+    times_out.put("\n");
+    fwrite(times_out.get_data(), 1, times_out.get_size(), stdout);
+    times_out.close();
+  }
+
+  bundle.close();
+  sidecar.close();
+  lcu_log_flush();
+
+  return (errors > 0);
+}
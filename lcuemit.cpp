@@ -0,0 +1,657 @@
+/* file "tcfggen/lcuemit.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcuemit.h"
+#endif
+
+#include "tcfggen/lcuemit.h"
+#include "tcfggen/lculog.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+#define TAIL    0
+#define HEAD    1
+#define WEIGHT  2
+
+unsigned lcu_bitlen(unsigned v);
+
+
+// Longest encoding strings of a task: the task word (FSMsel and up to 32
+// fwdsel and loop_addr bits each) and the names ("fwd<loop_addr>(<fwdsel>)")
+#define ENC_ROM_MAX     (11 + 32 + 32 + 1)
+#define ENC_NAME_MAX    (3 + 11 + 1 + 11 + 1 + 1)
+#define ENC_TASK_MAX    (ENC_ROM_MAX + 2*ENC_NAME_MAX)
+
+// Decimal number as with %d; returns the end of the digits
+static char *enc_int(char *s, int v)
+{
+  char digits[16];
+  char *p = digits + sizeof(digits);
+  unsigned u = (v < 0) ? 0U - (unsigned)v : (unsigned)v;
+
+  do {
+    *--p = '0' + u%10;
+    u /= 10;
+  } while (u != 0);
+
+  if (v < 0)
+    *s++ = '-';
+  while (p < digits + sizeof(digits))
+    *s++ = *p++;
+  return s;
+}
+
+// The num_bits low bits of v, most significant first
+static char *enc_bits(char *s, unsigned v, unsigned num_bits)
+{
+  while (num_bits > 0)
+  {
+    num_bits--;
+    *s++ = ((v >> num_bits) & 1) ? '1' : '0';
+  }
+  return s;
+}
+
+// Task name: bwd<loop_addr>, or fwd<loop_addr> followed by the fwdsel value
+// within the given delimiters (fwd3(0) for the VCG and CAC output, fwd3_0
+// for the FSM state names)
+static char *enc_task_name(char *s, const task_data &t, char open, char close)
+{
+  *s++ = (t.FSMsel == 0) ? 'b' : 'f';
+  *s++ = 'w';
+  *s++ = 'd';
+  s = enc_int(s, t.loop_addr);
+
+  if (t.FSMsel == 1)
+  {
+    *s++ = open;
+    s = enc_int(s, t.fwdsel);
+    if (close != '\0')
+      *s++ = close;
+  }
+
+  *s++ = '\0';
+  return s;
+}
+
+/*
+ * Compute the encodings of all the tasks. The strings are written straight
+ * into a single buffer, one after the other, so no allocation and no
+ * formatted output takes place per task.
+ */
+void encode_tasks(LcuContext *ctx)
+{
+  unsigned fwdsel_bits = lcu_bitlen(ctx->fwdsel_max);
+  unsigned nlp_bits = lcu_bitlen(ctx->nlp);
+  char *s;
+  unsigned i;
+
+  if (ctx->i_max == 0)
+    return;
+
+  if (ctx->enc_buf_size < ctx->i_max * ENC_TASK_MAX)
+  {
+    ctx->enc_buf_size = ctx->i_max * ENC_TASK_MAX;
+    ctx->enc_buf = (char *)ctx->arena.alloc(ctx->enc_buf_size);
+  }
+  s = ctx->enc_buf;
+
+  for (i=0; i<ctx->i_max; i++)
+  {
+    const task_data &t = ctx->task_data_arr[i];
+    task_enc &enc = ctx->task_enc_arr[i];
+
+    // Task word: FSMsel value, fwdsel and loop_addr bits, as wide as the
+    // largest value of the procedure requires. There is no fwdsel field
+    // without fwd sub-tasks, but the loop_addr field is at least a bit wide.
+    enc.rom_data = s;
+    s = enc_int(s, t.FSMsel);
+    s = enc_bits(s, t.fwdsel, fwdsel_bits);
+    s = enc_bits(s, t.loop_addr, (nlp_bits > 0) ? nlp_bits : 1);
+    *s++ = '\0';
+
+    enc.name = s;
+    s = enc_task_name(s, t, '(', ')');
+
+    enc.fsm_name = s;
+    s = enc_task_name(s, t, '_', '\0');
+  }
+}
+
+static void emit_pass(LcuContext *ctx, LcuEmitter **emitters, unsigned num_emitters)
+{
+  unsigned i, k, s;
+
+  for (k=0; k<num_emitters; k++)
+    emitters[k]->begin();
+
+  for (i=0; i<ctx->i_max; i++)
+  {
+    for (k=0; k<num_emitters; k++)
+      emitters[k]->visit_task(i);
+
+    for (s=ctx->succ_begin(i); s<ctx->succ_end(i); s++)
+      for (k=0; k<num_emitters; k++)
+        emitters[k]->visit_edge(i, ctx->succ_edge[s]);
+
+    for (k=0; k<num_emitters; k++)
+      emitters[k]->end_task(i);
+  }
+
+  for (k=0; k<num_emitters; k++)
+    emitters[k]->end();
+}
+
+void lcu_emit(LcuContext *ctx, LcuEmitter **emitters, unsigned num_emitters)
+{
+  if (num_emitters == 0)
+    return;
+
+  LcuPhaseTimer timer(&ctx->times, LCU_PH_EMIT);
+
+  if (!ctx->times.is_traced())
+  {
+    emit_pass(ctx, emitters, num_emitters);
+    return;
+  }
+
+  for (unsigned k=0; k<num_emitters; k++)
+  {
+    LcuPhaseTimer emitter_timer(&ctx->times, LCU_PH_EMIT_LUT + emitters[k]->get_kind());
+
+    emit_pass(ctx, &emitters[k], 1);
+  }
+}
+
+// Get the generation date, unless in reproducible mode
+static bool get_date(LcuContext *ctx, char *date_str)
+{
+  time_t t;
+
+  if (ctx->reproducible)
+    return false;
+
+  time(&t);
+  ctime_r(&t, date_str);
+  return true;
+}
+
+
+/*
+ * LUT
+ */
+void LcuLutEmitter::begin()
+{
+  char date_str[32];
+
+  /* Generate interface for the VHDL file */
+  /* Comments */
+  out->put("-- VHDL source for the loop_count_unit LUT generated by \"lcugen\"\n");
+  out->print("-- Filename: %s\n", ctx->lut_file_name);
+  out->put("-- Author: Nick Kavvadias, <nkavv@skiathos.physics.auth.gr>\n");
+  if (get_date(ctx, date_str))
+    out->print("-- Date: %s", date_str);
+  out->put("--\n");
+  out->put("\n");
+
+  /* Code generation for library inclusions */
+  out->put("library IEEE;\n");
+  out->put("use IEEE.std_logic_1164.all;\n");
+  out->put("use IEEE.std_logic_unsigned.all;\n");
+  out->put("use WORK.useful_functions_pkg.all;\n");
+  out->put("\n");
+
+  /* Generate entity declaration */
+  out->put("entity lcu_lut is\n");
+  out->put("\tgeneric (\n");
+  //
+  if (ctx->fwdsel_max > 0)
+    out->print("\t\tFWDSEL_MAX : integer := %d;\n", ctx->fwdsel_max);
+  //
+  out->print("\t\tNLP : integer := %d\n", ctx->nlp);
+  out->put("\t);\n");
+  out->put("\tport (\n");
+  out->put("\t\toe        : in std_logic;\n");
+  out->put("\t\tgloop_end : in std_logic;\n");
+  out->put("\t\tFSMsel    : in std_logic;\n");
+  //
+  if (ctx->fwdsel_max > 0)
+    out->put("\t\tfwdsel    : in std_logic_vector(log2(FWDSEL_MAX+1)-1 downto 0);\n");
+  //
+  out->put("\t\tloop_addr : in std_logic_vector(log2(NLP+1)-1 downto 0);\n");
+  //
+  if (ctx->fwdsel_max > 0)
+    out->put("\t\trom_data  : out std_logic_vector(log2(NLP+1)+log2(FWDSEL_MAX+1) downto 0)\n");
+  else
+    out->put("\t\trom_data  : out std_logic_vector(log2(NLP+1) downto 0)\n");
+  //
+  out->put("\t);\n");
+  out->put("end lcu_lut;\n");
+  out->put("\n");
+
+  /* Generate architecture declaration */
+  out->put("architecture synth of lcu_lut is\n");
+  //
+  if (ctx->fwdsel_max > 0)
+    out->put("signal rom_addr: std_logic_vector(log2(NLP+1)+log2(FWDSEL_MAX+1)+1 downto 0);\n");
+  else
+    out->put("signal rom_addr: std_logic_vector(log2(NLP+1)+1 downto 0);\n");
+
+  /* Continue with the rest of the architecture declaration */
+  out->put("begin\n");
+  out->put("\tprocess(oe, gloop_end, FSMsel, fwdsel, loop_addr)\n");
+  out->put("\tbegin\n");
+  out->put("\t--\n");
+  out->put("\trom_addr <= gloop_end & FSMsel & fwdsel & loop_addr;\n");
+  out->put("\t--\n");
+  out->put("\tif (oe = '1') then\n");
+  out->put("\t\tcase rom_addr is\n");
+}
+
+// LUT entry for edge e under the given value of gloop_end
+void LcuLutEmitter::print_entry(const char *gloop_end, unsigned e)
+{
+  out->put("\t\t  when \"");
+  out->put(gloop_end);
+  out->put(ctx->task_enc_arr[ ctx->edge_list[e][TAIL] ].rom_data);
+  out->put("\" => \"");
+  out->put(ctx->task_enc_arr[ ctx->edge_list[e][HEAD] ].rom_data);
+  out->put("\";\n");
+}
+
+void LcuLutEmitter::visit_edge(unsigned i, unsigned e)
+{
+  // FWD -> FWD, FWD -> BWD
+  if (ctx->task_data_arr[i].FSMsel == 1)
+  {
+    // Entries for gloop_end = 0 and gloop_end = 1
+    print_entry("0", e);
+    print_entry("1", e);
+  }
+
+  // BWD -> BWD, BWD -> FWD
+  if (ctx->task_data_arr[i].FSMsel == 0)
+  {
+    // If it is entry for gloop_end = 0
+    if (ctx->edge_list[e][WEIGHT] == 0)
+      print_entry("0", e);
+    // else if it is entry for gloop_end = 1
+    else if (ctx->edge_list[e][WEIGHT] == 1)
+      print_entry("1", e);
+  }
+}
+
+void LcuLutEmitter::end()
+{
+  out->put("\t\t--\n");
+  out->put("\t\twhen others => rom_data <= (others => '0');\n");
+  out->put("\tend case;\n");
+  out->put("\t\t--\n");
+  out->put("\telse\n");
+  out->put("\t\trom_data <= (others => 'Z');\n");
+  out->put("\tend if;\n");
+  out->put("\tend process;\n\n");
+  //
+  out->put("end synth;\n");
+}
+
+
+/*
+ * VCG
+ */
+void LcuVcgEmitter::begin()
+{
+  edges.open_memory();
+
+  /* Header and macroinstructions to the VCG interpreter */
+  out->print("graph: { title: \"%s\"\n", ctx->vcg_file_name);
+  out->put("\n");
+  out->put("x: 30\n");
+  out->put("y: 30\n");
+  out->put("height: 800\n");
+  out->put("width: 500\n");
+  out->put("stretch: 60\n");
+  out->put("shrink: 100\n");
+  // For acyclic graphs only
+  out->put("layoutalgorithm: minbackward\n");
+  out->put("display_edge_labels: yes\n");
+  out->put("late_edge_labels: yes\n");
+  out->put("near_edges: yes\n");
+  out->put("port_sharing: yes\n");
+  // Additional options
+  //
+  out->put("node.borderwidth: 3\n");
+  out->put("node.color: white\n");
+  out->put("node.textcolor: black\n");
+  out->put("node.bordercolor: black\n");
+  out->put("node.shape: circle\n");
+  out->put("edge.color: black\n");
+}
+
+void LcuVcgEmitter::visit_task(unsigned i)
+{
+  out->put("node: { title:\"");
+  out->put(ctx->task_enc_arr[i].name);
+  out->put("\" label:\"");
+  out->put(ctx->task_enc_arr[i].name);
+  out->put("\" }\n");
+}
+
+void LcuVcgEmitter::visit_edge(unsigned /* i */, unsigned e)
+{
+  // The edges follow all the nodes
+  edges.put("edge: {sourcename:\"");
+  edges.put(ctx->task_enc_arr[ ctx->edge_list[e][TAIL] ].name);
+  edges.put("\" targetname:\"");
+  edges.put(ctx->task_enc_arr[ ctx->edge_list[e][HEAD] ].name);
+  //
+  if (ctx->edge_list[e][WEIGHT] == -1)
+    edges.put("\" }\n");
+  else if (ctx->edge_list[e][WEIGHT] == 0)
+    edges.put("\" label:\"not(gloop_end)\" }\n");
+  else if (ctx->edge_list[e][WEIGHT] == 1)
+    edges.put("\" label:\"gloop_end\" }\n");
+}
+
+void LcuVcgEmitter::end()
+{
+  out->put("\n");
+  out->write(edges.get_data(), edges.get_size());
+  edges.close();
+
+  // Finalize VCG file
+  out->put("}\n");
+}
+
+
+/*
+ * FSM
+ */
+void LcuFsmEmitter::begin()
+{
+  char date_str[32];
+
+  transitions.open_memory();
+
+  /* Generate interface for the VHDL file */
+  /* Comments */
+  out->put("-- VHDL source for the loop_count_unit FSM generated by \"lcugen\"\n");
+  out->print("-- Filename: %s\n", ctx->fsm_file_name);
+  out->put("-- Author: Nick Kavvadias, <nkavv@skiathos.physics.auth.gr>\n");
+  if (get_date(ctx, date_str))
+    out->print("-- Date: %s", date_str);
+  out->put("--\n");
+  out->put("\n");
+
+  /* Code generation for library inclusions */
+  out->put("library IEEE;\n");
+  out->put("use IEEE.std_logic_1164.all;\n");
+  out->put("use WORK.useful_functions_pkg.all;\n");
+  out->put("\n");
+
+  /* Generate entity declaration */
+  out->put("entity lcu_fsm is\n");
+  out->put("\tgeneric (\n");
+  //
+  if (ctx->fwdsel_max > 0)
+    out->print("\t\tFWDSEL_MAX : integer := %d;\n", ctx->fwdsel_max);
+  //
+  out->print("\t\tNLP : integer := %d\n", ctx->nlp);
+  out->put("\t);\n");
+  out->put("\tport (\n");
+  out->put("\t\tclk       : in std_logic;\n");
+  out->put("\t\tstart     : in std_logic;\n");
+  out->put("\t\treset     : in std_logic;\n");
+  out->put("\t\tFSMbwd    : in std_logic;\n");
+  out->put("\t\tFSMfwd    : in std_logic;\n");
+  out->put("\t\tloop_end  : in std_logic;\n");
+  out->put("\t\tFSMsel    : out std_logic;\n");
+  //
+  if (ctx->fwdsel_max > 0)
+    out->put("\t\tfwdsel    : out std_logic_vector(log2(FWDSEL_MAX+1)-1 downto 0);\n");
+  //
+  out->put("\t\tloop_addr : out std_logic_vector(log2(NLP+1)-1 downto 0)\n");
+  out->put("\t);\n");
+  out->put("end lcu_fsm;\n");
+  out->put("\n");
+
+  /* Generate architecture declaration */
+  out->put("architecture synth of lcu_fsm is\n");
+  out->put("-- Data processing task declarations\n");
+}
+
+void LcuFsmEmitter::visit_task(unsigned i)
+{
+  // State declaration
+  out->put("constant ");
+  out->put(ctx->task_enc_arr[i].fsm_name);
+  //
+  if (ctx->fwdsel_max > 0)
+    out->put("\t: std_logic_vector(log2(NLP+1)+log2(FWDSEL_MAX+1) downto 0) := \"");
+  else
+    out->put("\t: std_logic_vector(log2(NLP+1) downto 0) := \"");
+  //
+  out->put(ctx->task_enc_arr[i].rom_data);
+  out->put("\";\n");
+
+  stay_e = -1;
+  exit_e = -1;
+}
+
+void LcuFsmEmitter::visit_edge(unsigned i, unsigned e)
+{
+  const char *cur = ctx->task_enc_arr[i].fsm_name;
+
+  // BWD -> BWD, BWD -> FWD: emitted once both out-edges are known
+  if (ctx->task_data_arr[i].FSMsel == 0)
+  {
+    if (ctx->edge_list[e][WEIGHT] == 0 && stay_e == -1)
+      stay_e = e;
+    else if (ctx->edge_list[e][WEIGHT] == 1 && exit_e == -1)
+      exit_e = e;
+    return;
+  }
+
+  // FWD -> FWD, FWD -> BWD
+  if (ctx->task_data_arr[i].FSMsel == 1)
+  {
+    transitions.put("\t\t  when ");
+    transitions.put(cur);
+    transitions.put(" =>\n");
+
+    // If it is the first task of the algorithm (FWD0_0)
+    if (ctx->task_data_arr[i].loop_addr == 0)
+      transitions.put("\t\t\tif (start = '1') then\n");
+    else
+      transitions.put("\t\t\tif (FSMfwd = '1') then\n");
+    //
+    transitions.put("\t\t\t  following <= ");
+    transitions.put(ctx->task_enc_arr[ ctx->edge_list[e][HEAD] ].fsm_name);
+    transitions.put(";\n");
+    transitions.put("\t\t\telse\n");
+    transitions.put("\t\t\t  following <= ");
+    transitions.put(cur);
+    transitions.put(";\n");
+    transitions.put("\t\t\tend if;\n");
+  }
+}
+
+void LcuFsmEmitter::end_task(unsigned i)
+{
+  const char *cur = ctx->task_enc_arr[i].fsm_name;
+
+  if (ctx->task_data_arr[i].FSMsel != 0 || (stay_e == -1 && exit_e == -1))
+    return;
+
+  lcu_claim(stay_e != -1 && exit_e != -1, "Malformed bwd task in the task graph");
+
+  transitions.put("\t\t  when ");
+  transitions.put(cur);
+  transitions.put(" =>\n");
+
+  transitions.put("\t\t\tif (FSMbwd = '1' and loop_end = '1') then\n");
+  transitions.put("\t\t\t  following <= ");
+  transitions.put(ctx->task_enc_arr[ ctx->edge_list[exit_e][HEAD] ].fsm_name);
+  transitions.put(";\n");
+  //
+  // if not an inner loop task
+  if (ctx->task_data_arr[i].inner_loop == 0)
+  {
+    transitions.put("\t\t\telsif (FSMbwd = '1' and loop_end = '0') then\n");
+    transitions.put("\t\t\t  following <= ");
+    transitions.put(ctx->task_enc_arr[ ctx->edge_list[stay_e][HEAD] ].fsm_name);
+    transitions.put(";\n");
+  }
+  //
+  transitions.put("\t\t\telse\n");
+  transitions.put("\t\t\t  following <= ");
+  transitions.put(cur);
+  transitions.put(";\n");
+  //
+  transitions.put("\t\t\tend if;\n");
+}
+
+void LcuFsmEmitter::end()
+{
+  out->put("\n");
+  //
+  if (ctx->fwdsel_max > 0)
+    out->put("signal current,following: std_logic_vector(log2(NLP+1)+log2(FWDSEL_MAX+1) downto 0);\n");
+  else
+    out->put("signal current,following: std_logic_vector(log2(NLP+1) downto 0);\n");
+  //
+  out->put("--\n");
+  /* Continue with the rest of the architecture declaration */
+  out->put("begin\n");
+  out->put("\t-- next state logic\n");
+  out->put("\tprocess(current, start, FSMbwd, FSMfwd, loop_end)\n");
+  out->put("\tbegin\n");
+  out->put("\t\tcase current is\n");
+
+  out->write(transitions.get_data(), transitions.get_size());
+  transitions.close();
+
+  out->put("\t\t  when bwd0 =>\n");
+  out->put("\t\t\tif (FSMbwd = '1') then\n");
+  out->put("\t\t\t  following <= fwd0_0;\n");
+  out->put("\t\t\telse\n");
+  out->put("\t\t\t  following <= bwd0;\n");
+  out->put("\t\t\tend if;\n");
+  //
+  out->put("\t\t  -- all other cases\n");
+  out->put("\t\t  when others =>\n");
+  out->put("\t\t\t  following <= fwd0_0;\n");
+  out->put("\t\t\t--\n");
+
+  out->put("\t\tend case;\n");
+  out->put("\tend process;\n");
+  out->put("\n");
+
+  out->put("\t-- current state logic\n");
+  out->put("\tprocess(clk, reset)\n");
+  out->put("\tbegin\n");
+  out->put("\t\tif (reset='1') then\n");
+  out->put("\t\t  current <= fwd0_0;\n");
+  out->put("\t\telsif (clk'event and clk='1') then\n");
+  out->put("\t\t  current <= following;\n");
+  out->put("\t\tend if;\n");
+  out->put("\tend process;\n");
+  out->put("\n");
+
+  out->put("\t-- output logic\n");
+  out->put("\tprocess(current)\n");
+  out->put("\tbegin\n");
+  out->put("\t\t-- In all cases, the output signals are fields of the current state\n");
+  //
+  if (ctx->fwdsel_max > 0)
+  {
+    out->put("\t\tFSMsel <= current(log2(NLP+1)+log2(FWDSEL_MAX+1));\n");
+    out->put("\t\tfwdsel <= current(log2(NLP+1)+log2(FWDSEL_MAX+1)-1 downto log2(NLP+1));\n");
+  }
+  else
+    out->put("\t\tFSMsel <= current(log2(NLP+1));\n");
+  //
+  out->put("\t\tloop_addr <= current(log2(NLP+1)-1 downto 0);\n");
+  out->put("\tend process;\n");
+  out->put("\n");
+
+  out->put("end synth;\n");
+}
+
+
+/*
+ * CAC
+ */
+void LcuCacEmitter::begin()
+{
+  cac_task_id = 0;
+}
+
+// Task selection LUT entry leading to task head
+void LcuCacEmitter::print_entry(unsigned head)
+{
+  out->put("ttlut_mem[0x");
+  out->put_hex(cac_task_id);
+  out->put("].task_data=0x");
+  out->put_hex(ctx->task_data_arr[head].taskid);
+  out->put("; ");
+  //
+  if (ctx->task_data_arr[head].FSMsel == 1 || ctx->task_data_arr[head].FSMsel == 0)
+  {
+    out->put("ttlut_mem[0x");
+    out->put_hex(cac_task_id);
+    out->put((ctx->task_data_arr[head].FSMsel == 1) ? "].ttsel=0x1; " : "].ttsel=0x0; ");
+  }
+  //
+  out->put("ttlut_mem[0x");
+  out->put_hex(cac_task_id);
+  out->put("].loop_addr=0x");
+  out->put_hex(ctx->task_data_arr[head].loop_addr);
+  out->put(";\n");
+  cac_task_id++;
+}
+
+void LcuCacEmitter::visit_edge(unsigned /* i */, unsigned e)
+{
+  unsigned head = ctx->edge_list[e][HEAD];
+
+  // CFG edge: task_data_arr[i] --> task_data_arr[head]
+  out->put("//# ");
+  out->put(ctx->task_enc_arr[ ctx->edge_list[e][TAIL] ].name);
+  out->put(" -> ");
+  out->put(ctx->task_enc_arr[head].name);
+  out->put("\n");
+
+  // Unconditional transitions take two entries
+  if (ctx->edge_list[e][WEIGHT] == -1)
+  {
+    print_entry(head);
+    print_entry(head);
+  }
+  else if (ctx->edge_list[e][WEIGHT] == 0 || ctx->edge_list[e][WEIGHT] == 1)
+    print_entry(head);
+}
+
+void LcuCacEmitter::end()
+{
+  out->put("\n");
+}
@@ -0,0 +1,125 @@
+/* file "tcfggen/lcuemit.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUEMIT_H
+#define TCFGGEN_LCUEMIT_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcuemit.h"
+#endif
+
+#include "tcfggen/lcuctx.h"
+#include "tcfggen/lcusink.h"
+
+
+/*
+ * LcuEmitter = backend that generates one artifact from the TCFG.
+ * lcu_emit() walks the task graph once (tasks in order, each followed by its
+ * out-edges in edge_list order) and dispatches every step to all the
+ * backends, which read the task encodings precomputed in ctx->task_enc_arr.
+ * A backend whose output is not in traversal order (e.g. all the nodes
+ * before all the edges) collects the late parts in a memory section and
+ * writes it out in end(). In a traced run, every backend gets a traversal
+ * of its own, so that its time shows up as a phase of the timeline.
+ */
+class LcuEmitter {
+  public:
+    LcuEmitter(LcuContext *ctx_in, LcuSink *out_in, int kind_in)
+      : ctx(ctx_in), out(out_in), kind(kind_in) { }
+    virtual ~LcuEmitter() { }
+
+    virtual void begin() { }
+    virtual void visit_task(unsigned /* i */) { }
+    virtual void visit_edge(unsigned /* i */, unsigned /* e */) { }   // edge e leaves task i
+    virtual void end_task(unsigned /* i */) { }
+    virtual void end() { }
+
+    void set_sink(LcuSink *out_in)      { out = out_in; }
+    int get_kind() const                { return kind; }   // LCU_ART_*
+
+  protected:
+    LcuContext *ctx;
+    LcuSink *out;
+    int kind;
+};
+
+// VHDL source for the task selection LUT (-lut)
+class LcuLutEmitter : public LcuEmitter {
+  public:
+    LcuLutEmitter(LcuContext *ctx_in, LcuSink *out_in)
+      : LcuEmitter(ctx_in, out_in, LCU_ART_LUT) { }
+
+    void begin();
+    void visit_edge(unsigned i, unsigned e);
+    void end();
+
+  protected:
+    void print_entry(const char *gloop_end, unsigned e);
+};
+
+// VCG visualization of the TCFG (-vcg)
+class LcuVcgEmitter : public LcuEmitter {
+  public:
+    LcuVcgEmitter(LcuContext *ctx_in, LcuSink *out_in)
+      : LcuEmitter(ctx_in, out_in, LCU_ART_VCG) { }
+
+    void begin();
+    void visit_task(unsigned i);
+    void visit_edge(unsigned i, unsigned e);
+    void end();
+
+  protected:
+    LcuSink edges;
+};
+
+// VHDL source for the FSM implementation of the task selection unit (-fsm)
+class LcuFsmEmitter : public LcuEmitter {
+  public:
+    LcuFsmEmitter(LcuContext *ctx_in, LcuSink *out_in)
+      : LcuEmitter(ctx_in, out_in, LCU_ART_FSM) { }
+
+    void begin();
+    void visit_task(unsigned i);
+    void visit_edge(unsigned i, unsigned e);
+    void end_task(unsigned i);
+    void end();
+
+  protected:
+    LcuSink transitions;
+    int stay_e, exit_e;         // out-edges of the current bwd task
+};
+
+// C initialization code of the task selection unit (-cac)
+class LcuCacEmitter : public LcuEmitter {
+  public:
+    LcuCacEmitter(LcuContext *ctx_in, LcuSink *out_in)
+      : LcuEmitter(ctx_in, out_in, LCU_ART_CAC) { }
+
+    void begin();
+    void visit_edge(unsigned i, unsigned e);
+    void end();
+
+  protected:
+    void print_entry(unsigned head);
+
+    unsigned cac_task_id;
+};
+
+// Compute the encodings of all the tasks into ctx->task_enc_arr
+void encode_tasks(LcuContext *ctx);
+
+// Run the given backends over the TCFG in a single traversal
+void lcu_emit(LcuContext *ctx, LcuEmitter **emitters, unsigned num_emitters);
+
+
+#endif /* TCFGGEN_LCUEMIT_H */
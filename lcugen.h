@@ -14,14 +14,10 @@
 #ifndef TCFGGEN_LCUGEN_H
 #define TCFGGEN_LCUGEN_H
 
-#include <machine/copyright.h>
-
 #ifdef USE_PRAGMA_INTERFACE
 #pragma interface "tcfggen/lcugen.h"
 #endif
 
-#include <machine/machine.h>
-
 
 typedef struct task_data_t task_data;
 typedef struct address_t address;
@@ -29,6 +25,8 @@ typedef struct data_t data;
 typedef struct task_trans_t task_trans;
 typedef struct cfg_instr_pos_t cfg_instr_pos;
 typedef struct tcfg_edge_t tcfg_edge;
+typedef struct task_edge_t task_edge;
+typedef struct task_enc_t task_enc;
 
 /*typedef*/ struct task_data_t
 {
@@ -40,7 +38,7 @@ typedef struct tcfg_edge_t tcfg_edge;
 	unsigned loop_addr;
 	unsigned inner_loop;
 	unsigned annotation;
-	int      bb_list[40];
+	int     *bb_list;
 	unsigned bb_list_size;
 }/* task_data*/;
 
@@ -80,5 +78,20 @@ typedef struct tcfg_edge_t tcfg_edge;
 	unsigned next_loop_addr;
 }/* tcfg_edge*/;
 
+/*typedef*/ struct task_edge_t
+{
+	int field[3];   // TAIL, HEAD, WEIGHT
+
+	int& operator[](int k)             { return field[k]; }
+	const int& operator[](int k) const { return field[k]; }
+}/* task_edge*/;
+
+/*typedef*/ struct task_enc_t
+{
+	const char *rom_data;    // encoded task word (FSMsel, fwdsel, loop_addr)
+	const char *name;        // e.g. fwd3(0), as in the VCG and CAC output
+	const char *fsm_name;    // e.g. fwd3_0, as in the FSM state names
+}/* task_enc*/;
+
 
 #endif /* TCFGGEN_LCUGEN_H */
@@ -0,0 +1,280 @@
+/* file "tcfggen/lcuinfo.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcuinfo.h"
+#endif
+
+#include "tcfggen/lcuinfo.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+
+LcuLoopTable::~LcuLoopTable()
+{
+  free(name);
+}
+
+void LcuLoopTable::clear()
+{
+  free(name);
+  name = NULL;
+  nodes.clear();
+}
+
+void LcuLoopTable::set_name(const char *s, size_t len)
+{
+  free(name);
+  name = (char *)malloc(len+1);
+  memcpy(name, s, len);
+  name[len] = '\0';
+}
+
+void LcuLoopTable::set_node(unsigned node, int depth, bool begin, bool end, bool exit)
+{
+  if (node >= nodes.size())
+  {
+    node_t n = { 0, false, false, false };
+    nodes.resize(node+1, n);
+  }
+
+  nodes[node].depth = depth;
+  nodes[node].begin = begin;
+  nodes[node].end = end;
+  nodes[node].exit = exit;
+}
+
+
+LcuLoopReport::LcuLoopReport()
+{
+  data = NULL;
+  size = 0;
+  pos = 0;
+  line = unit_line = unit_count = 0;
+}
+
+bool LcuLoopReport::open(const char *file_name)
+{
+  struct stat st;
+  int fd;
+
+  close();
+
+  fd = ::open(file_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  if (fstat(fd, &st) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  size = st.st_size;
+  if (size > 0)
+  {
+    void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (p == MAP_FAILED)
+    {
+      ::close(fd);
+      size = 0;
+      return false;
+    }
+    data = (const char *)p;
+  }
+
+  // The mapping outlives the descriptor
+  ::close(fd);
+  return true;
+}
+
+void LcuLoopReport::close()
+{
+  if (data != NULL)
+    munmap((void *)data, size);
+  data = NULL;
+  size = 0;
+  pos = 0;
+  line = unit_line = unit_count = 0;
+}
+
+bool LcuLoopReport::read_line(const char **begin, const char **end)
+{
+  const char *nl;
+
+  if (pos >= size)
+    return false;
+
+  *begin = data + pos;
+  nl = (const char *)memchr(*begin, '\n', size - pos);
+  *end = (nl != NULL) ? nl : data + size;
+  pos = (*end - data) + 1;
+  line++;
+
+  return true;
+}
+
+static const char *skip_blanks(const char *p, const char *end)
+{
+  while (p < end && isspace((unsigned char)*p))
+    p++;
+  return p;
+}
+
+static bool parse_uint(const char **p, const char *end, unsigned *val)
+{
+  const char *q = *p;
+  unsigned v = 0;
+
+  if (q == end || !isdigit((unsigned char)*q))
+    return false;
+  for (; q < end && isdigit((unsigned char)*q); q++)
+    v = v*10 + (*q - '0');
+
+  *val = v;
+  *p = q;
+  return true;
+}
+
+// A Y/N flag; any word starting with Y, N, 1 or 0 will do
+static bool parse_flag(const char **p, const char *end, bool *val)
+{
+  const char *q = skip_blanks(*p, end);
+
+  if (q == end)
+    return false;
+  if (*q == 'Y' || *q == 'y' || *q == '1')
+    *val = true;
+  else if (*q == 'N' || *q == 'n' || *q == '0')
+    *val = false;
+  else
+    return false;
+
+  while (q < end && !isspace((unsigned char)*q))
+    q++;
+  *p = q;
+  return true;
+}
+
+// "<node>: <depth> <begin> <end> <exit>"
+static bool parse_node(const char *p, const char *end, LcuLoopTable *table)
+{
+  unsigned node, depth;
+  bool begin, end_flag, exit;
+
+  p = skip_blanks(p, end);
+  if (!parse_uint(&p, end, &node))
+    return false;
+  p = skip_blanks(p, end);
+  if (p == end || *p != ':')
+    return false;
+  p = skip_blanks(p+1, end);
+  if (!parse_uint(&p, end, &depth))
+    return false;
+  if (!parse_flag(&p, end, &begin) || !parse_flag(&p, end, &end_flag) ||
+      !parse_flag(&p, end, &exit))
+    return false;
+
+  table->set_node(node, depth, begin, end_flag, exit);
+  return true;
+}
+
+// 'Procedure "<name>":' on a line of its own
+static bool parse_name(const char *p, const char *end,
+                       const char **name, size_t *len)
+{
+  static const char tag[] = "Procedure \"";
+  const char *q;
+
+  if ((size_t)(end - p) < sizeof(tag)-1 || memcmp(p, tag, sizeof(tag)-1) != 0)
+    return false;
+  p += sizeof(tag)-1;
+
+  q = (const char *)memchr(p, '"', end - p);
+  if (q == NULL || q+1 == end || q[1] != ':' || skip_blanks(q+2, end) != end)
+    return false;
+
+  *name = p;
+  *len = q - p;
+  return true;
+}
+
+bool LcuLoopReport::next_unit(LcuLoopTable *table)
+{
+  const char *b, *e;
+  const char *name = NULL;
+  size_t name_len = 0;
+  bool in_block = false, have_nodes = false;
+  size_t line_pos;
+
+  table->clear();
+
+  while (true)
+  {
+    line_pos = pos;
+    if (!read_line(&b, &e))
+      break;
+
+    if (!in_block)
+    {
+      if (parse_name(b, e, &name, &name_len))
+        continue;
+      if (e - b >= 10 && memcmp(b, "Loop info:", 10) == 0)
+      {
+        in_block = true;
+        unit_line = line;
+      }
+      continue;
+    }
+
+    // The column header precedes the first node
+    if (parse_node(b, e, table))
+      have_nodes = true;
+    else if (have_nodes)
+    {
+      // The line may open the next unit
+      pos = line_pos;
+      line--;
+      break;
+    }
+  }
+
+  if (!in_block)
+    return false;
+
+  if (name != NULL)
+    table->set_name(name, name_len);
+  else
+  {
+    char buf[32];
+
+    sprintf(buf, "unit%u", unit_count);
+    table->set_name(buf, strlen(buf));
+  }
+  unit_count++;
+
+  return true;
+}
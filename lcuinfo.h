@@ -0,0 +1,116 @@
+/* file "tcfggen/lcuinfo.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUINFO_H
+#define TCFGGEN_LCUINFO_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcuinfo.h"
+#endif
+
+#include <stddef.h>
+#include <vector>
+
+
+/*
+ * LcuLoopInfo = the natural loop analysis results that the TCFG construction
+ * needs, i.e. the "Loop info" table of the README: the loop depth and the
+ * begin/end/exit flags of every CFG node. The nodes are numbered densely,
+ * from 0 to num_nodes()-1.
+ *
+ * The pass adapts the MachSUIF NaturalLoopInfo to it; lcudriver reads it
+ * from loop reports. Everything beyond this interface (lcugen, the emitters)
+ * is independent of MachSUIF.
+ */
+class LcuLoopInfo {
+  public:
+    virtual ~LcuLoopInfo()              { }
+
+    virtual unsigned num_nodes() const = 0;
+    virtual int  loop_depth(unsigned node) const = 0;
+    virtual bool is_loop_begin(unsigned node) const = 0;
+    virtual bool is_loop_end(unsigned node) const = 0;
+    virtual bool is_loop_exit(unsigned node) const = 0;
+};
+
+/*
+ * LcuLoopTable = loop info held in a table of its own, along with the name
+ * of the procedure it belongs to.
+ */
+class LcuLoopTable : public LcuLoopInfo {
+  public:
+    LcuLoopTable()                      { name = NULL; }
+    ~LcuLoopTable();
+
+    void clear();
+    void set_name(const char *s, size_t len);
+    const char *get_name() const        { return name; }
+
+    // Nodes that are never set get depth 0 and no flags
+    void set_node(unsigned node, int depth, bool begin, bool end, bool exit);
+
+    unsigned num_nodes() const          { return nodes.size(); }
+    int  loop_depth(unsigned node) const    { return nodes[node].depth; }
+    bool is_loop_begin(unsigned node) const { return nodes[node].begin; }
+    bool is_loop_end(unsigned node) const   { return nodes[node].end; }
+    bool is_loop_exit(unsigned node) const  { return nodes[node].exit; }
+
+  protected:
+    struct node_t {
+      int  depth;
+      bool begin, end, exit;
+    };
+
+    char *name;
+    std::vector<node_t> nodes;
+
+  private:
+    LcuLoopTable(const LcuLoopTable&);
+    LcuLoopTable& operator=(const LcuLoopTable&);
+};
+
+/*
+ * LcuLoopReport = reader of loop analysis reports (loop_results.txt written
+ * with "-report full"), memory-mapped. Each "Loop info:" block is a unit; its
+ * name is taken from the 'Procedure "<name>":' line before it, if any.
+ * Anything else in the report (dominance dumps, summaries, times) is skipped.
+ */
+class LcuLoopReport {
+  public:
+    LcuLoopReport();
+    ~LcuLoopReport()                    { close(); }
+
+    bool open(const char *file_name);
+    void close();
+
+    // Read the next unit into table; false at the end of the report
+    bool next_unit(LcuLoopTable *table);
+
+    // Number of the report line where the last unit read begins
+    unsigned get_line() const           { return unit_line; }
+
+  protected:
+    bool read_line(const char **begin, const char **end);
+
+    const char *data;
+    size_t size;
+    size_t pos;
+    unsigned line, unit_line, unit_count;
+
+  private:
+    LcuLoopReport(const LcuLoopReport&);
+    LcuLoopReport& operator=(const LcuLoopReport&);
+};
+
+
+#endif /* TCFGGEN_LCUINFO_H */
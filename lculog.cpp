@@ -0,0 +1,201 @@
+/* file "tcfggen/lculog.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lculog.h"
+#endif
+
+#include "tcfggen/lculog.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+#define LOG_RING_SIZE   (256*1024)
+#define LOG_LINE_SIZE   512
+
+
+int lcu_log_level = LCU_LOG_WARN;
+
+static const char *level_prefix[] = {
+  "ERR: ", "WRN: ", "INF: ", "DBG: ", "TRC: "
+};
+
+// The ring holds the bytes [tail, head) (both counters only grow)
+static char ring[LOG_RING_SIZE];
+static unsigned long long ring_head = 0, ring_tail = 0;
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  data_cv = PTHREAD_COND_INITIALIZER;    // bytes queued
+static pthread_cond_t  space_cv = PTHREAD_COND_INITIALIZER;   // bytes written
+static pthread_once_t  writer_once = PTHREAD_ONCE_INIT;
+static pthread_t       writer_thread;
+
+// A message continues the line of the previous one of the same thread
+// unless that ended with a newline; only new lines get the level prefix
+static __thread bool at_line_start = true;
+
+
+static void *writer_main(void * /* arg */)
+{
+  pthread_mutex_lock(&ring_lock);
+
+  while (true)
+  {
+    while (ring_head == ring_tail)
+      pthread_cond_wait(&data_cv, &ring_lock);
+
+    // Write up to the end of the queued bytes or of the ring, whichever
+    // comes first
+    size_t pos = ring_tail % LOG_RING_SIZE;
+    size_t n = ring_head - ring_tail;
+
+    if (n > LOG_RING_SIZE - pos)
+      n = LOG_RING_SIZE - pos;
+
+    pthread_mutex_unlock(&ring_lock);
+    fwrite(ring+pos, 1, n, stderr);
+    pthread_mutex_lock(&ring_lock);
+
+    ring_tail += n;
+    pthread_cond_broadcast(&space_cv);
+  }
+
+  return NULL;
+}
+
+static void start_writer()
+{
+  if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0)
+  {
+    fprintf(stderr, "Error! Can not create the log writer thread.\n");
+    exit(1);
+  }
+  pthread_detach(writer_thread);
+
+  // Messages still queued at exit are written out
+  atexit(lcu_log_flush);
+}
+
+static void enqueue(const char *s, size_t len)
+{
+  pthread_once(&writer_once, start_writer);
+
+  pthread_mutex_lock(&ring_lock);
+
+  while (len > 0)
+  {
+    while (ring_head - ring_tail == LOG_RING_SIZE)
+      pthread_cond_wait(&space_cv, &ring_lock);
+
+    size_t pos = ring_head % LOG_RING_SIZE;
+    size_t n = LOG_RING_SIZE - (ring_head - ring_tail);
+
+    if (n > LOG_RING_SIZE - pos)
+      n = LOG_RING_SIZE - pos;
+    if (n > len)
+      n = len;
+
+    memcpy(ring+pos, s, n);
+    ring_head += n;
+    s += n;
+    len -= n;
+    pthread_cond_signal(&data_cv);
+  }
+
+  pthread_mutex_unlock(&ring_lock);
+}
+
+void lcu_log_set_level(int level)
+{
+  if (level < LCU_LOG_ERROR)
+    level = LCU_LOG_ERROR;
+  if (level > LCU_LOG_TRACE)
+    level = LCU_LOG_TRACE;
+  lcu_log_level = level;
+}
+
+void lcu_log_write(int level, const char *fmt, ...)
+{
+  char line[LOG_LINE_SIZE];
+  char *msg = line;
+  size_t len = 0;
+  va_list ap;
+  int n;
+
+  if (level < LCU_LOG_ERROR)
+    level = LCU_LOG_ERROR;
+  if (level > LCU_LOG_TRACE)
+    level = LCU_LOG_TRACE;
+
+  if (at_line_start)
+  {
+    strcpy(line, level_prefix[level]);
+    len = strlen(line);
+  }
+
+  va_start(ap, fmt);
+  n = vsnprintf(line+len, LOG_LINE_SIZE-len, fmt, ap);
+  va_end(ap);
+
+  if (n < 0)
+    return;
+
+  // Long messages are formatted again into a buffer of their own
+  if (len + n >= LOG_LINE_SIZE)
+  {
+    msg = (char *)malloc(len + n + 1);
+    if (msg == NULL)
+      return;
+    memcpy(msg, line, len);
+    va_start(ap, fmt);
+    vsnprintf(msg+len, n+1, fmt, ap);
+    va_end(ap);
+  }
+  len += n;
+
+  if (len > 0)
+    at_line_start = (msg[len-1] == '\n');
+
+  if (level == LCU_LOG_ERROR)
+  {
+    lcu_log_flush();
+    fwrite(msg, 1, len, stderr);
+    fflush(stderr);
+  }
+  else
+    enqueue(msg, len);
+
+  if (msg != line)
+    free(msg);
+}
+
+void lcu_claim_failed(const char *file, int line, const char *msg)
+{
+  lcu_log_write(LCU_LOG_ERROR, "%s:%d: %s\n", file, line, msg);
+  exit(1);
+}
+
+void lcu_log_flush()
+{
+  pthread_mutex_lock(&ring_lock);
+  while (ring_tail != ring_head)
+    pthread_cond_wait(&space_cv, &ring_lock);
+  pthread_mutex_unlock(&ring_lock);
+}
@@ -0,0 +1,77 @@
+/* file "tcfggen/lculog.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCULOG_H
+#define TCFGGEN_LCULOG_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lculog.h"
+#endif
+
+
+/*
+ * Leveled diagnostics. A message is written if its level is at most the
+ * runtime level (-v, default LCU_LOG_WARN) and at most LCU_LOG_MAX_LEVEL.
+ * The latter is fixed at compile time: messages above it, including the
+ * evaluation of their arguments, are removed from the build altogether.
+ *
+ * Messages are formatted by the calling thread and queued in a ring buffer
+ * that a background thread writes to stderr, so logging threads only share
+ * a short copy. Errors are written synchronously, after the queued messages.
+ */
+#define LCU_LOG_ERROR   0
+#define LCU_LOG_WARN    1
+#define LCU_LOG_INFO    2
+#define LCU_LOG_DEBUG   3       // per-procedure listings
+#define LCU_LOG_TRACE   4       // per-BB and per-task details
+
+#ifndef LCU_LOG_MAX_LEVEL
+#  ifdef NDEBUG
+#    define LCU_LOG_MAX_LEVEL LCU_LOG_INFO
+#  else
+#    define LCU_LOG_MAX_LEVEL LCU_LOG_TRACE
+#  endif
+#endif
+
+extern int lcu_log_level;
+
+void lcu_log_set_level(int level);
+void lcu_log_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Wait until all queued messages have been written
+void lcu_log_flush();
+
+#define lcu_log_enabled(level) \
+  ((level) <= LCU_LOG_MAX_LEVEL && (level) <= lcu_log_level)
+
+#define lcu_log(level, args...) \
+  do { \
+    if (lcu_log_enabled(level)) \
+      lcu_log_write(level, args); \
+  } while (0)
+
+#define dbg_printf(args...) lcu_log(LCU_LOG_DEBUG, args)
+#define trc_printf(args...) lcu_log(LCU_LOG_TRACE, args)
+
+// claim() of the code that is built without MachSUIF: report the broken
+// assertion as an error and exit
+void lcu_claim_failed(const char *file, int line, const char *msg);
+
+#define lcu_claim(cond, msg) \
+  do { \
+    if (!(cond)) \
+      lcu_claim_failed(__FILE__, __LINE__, msg); \
+  } while (0)
+
+
+#endif /* TCFGGEN_LCULOG_H */
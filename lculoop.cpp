@@ -0,0 +1,374 @@
+/* file "tcfggen/lculoop.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lculoop.h"
+#endif
+
+#include "tcfggen/lculoop.h"
+#include "tcfggen/lculog.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+#define UNSEEN    (~0U)
+#define ON_PATH   (~1U)
+
+
+LcuCfgGraph::LcuCfgGraph()
+{
+  num_nodes = num_edges = 0;
+  entry = 0;
+  succ_start = succ = NULL;
+  pred_start = pred = NULL;
+  arena = NULL;
+  max_edges = 0;
+  edge_from = edge_to = NULL;
+}
+
+void LcuCfgGraph::init(LcuArena *arena_in, unsigned num_nodes_in,
+                       unsigned max_edges_in)
+{
+  arena = arena_in;
+  num_nodes = num_nodes_in;
+  num_edges = 0;
+  max_edges = max_edges_in;
+
+  edge_from = (unsigned *)arena->alloc((max_edges+1)*sizeof(unsigned));
+  edge_to = (unsigned *)arena->alloc((max_edges+1)*sizeof(unsigned));
+  succ_start = (unsigned *)arena->alloc((num_nodes+1)*sizeof(unsigned));
+  pred_start = (unsigned *)arena->alloc((num_nodes+1)*sizeof(unsigned));
+  succ = pred = NULL;
+}
+
+void LcuCfgGraph::add_edge(unsigned from, unsigned to)
+{
+  lcu_claim(num_edges < max_edges && from < num_nodes && to < num_nodes,
+            "CFG edge out of range");
+
+  edge_from[num_edges] = from;
+  edge_to[num_edges] = to;
+  num_edges++;
+}
+
+// Counting sort of the edges by source and by target; both keep the order
+// the edges were added in
+void LcuCfgGraph::finish(unsigned entry_in)
+{
+  unsigned *succ_pos, *pred_pos;
+  unsigned e, n;
+
+  lcu_claim(entry_in < num_nodes, "CFG entry node out of range");
+  entry = entry_in;
+
+  succ = (unsigned *)arena->alloc((num_edges+1)*sizeof(unsigned));
+  pred = (unsigned *)arena->alloc((num_edges+1)*sizeof(unsigned));
+  succ_pos = (unsigned *)arena->alloc((num_nodes+1)*sizeof(unsigned));
+  pred_pos = (unsigned *)arena->alloc((num_nodes+1)*sizeof(unsigned));
+
+  memset(succ_start, 0, (num_nodes+1)*sizeof(unsigned));
+  memset(pred_start, 0, (num_nodes+1)*sizeof(unsigned));
+
+  for (e=0; e<num_edges; e++)
+  {
+    succ_start[edge_from[e]+1]++;
+    pred_start[edge_to[e]+1]++;
+  }
+  for (n=0; n<num_nodes; n++)
+  {
+    succ_start[n+1] += succ_start[n];
+    pred_start[n+1] += pred_start[n];
+  }
+
+  memcpy(succ_pos, succ_start, num_nodes*sizeof(unsigned));
+  memcpy(pred_pos, pred_start, num_nodes*sizeof(unsigned));
+
+  for (e=0; e<num_edges; e++)
+  {
+    succ[succ_pos[edge_from[e]]++] = edge_to[e];
+    pred[pred_pos[edge_to[e]]++] = edge_from[e];
+  }
+}
+
+
+LcuLoopFinder::LcuLoopFinder()
+{
+  arena = NULL;
+  graph = NULL;
+  idom = NULL;
+  dom_pre = dom_post = NULL;
+  depth = NULL;
+  flags = NULL;
+}
+
+// Nearest common dominator of two nodes, by their postorder numbers
+static unsigned intersect(const unsigned *doms, unsigned a, unsigned b)
+{
+  while (a != b)
+  {
+    while (a < b)
+      a = doms[a];
+    while (b < a)
+      b = doms[b];
+  }
+  return a;
+}
+
+void LcuLoopFinder::find_dominators(LcuArena *arena_in, const LcuCfgGraph *graph_in)
+{
+  unsigned n, i, k, sp, num_po, t;
+  unsigned *po_num, *po_node, *doms, *stack, *cursor;
+  unsigned *child_start, *child;
+  bool changed;
+
+  arena = arena_in;
+  graph = graph_in;
+  n = graph->num_nodes;
+
+  idom = (int *)arena->alloc((n+1)*sizeof(int));
+  dom_pre = (unsigned *)arena->alloc((n+1)*sizeof(unsigned));
+  dom_post = (unsigned *)arena->alloc((n+1)*sizeof(unsigned));
+  depth = (unsigned *)arena->alloc((n+1)*sizeof(unsigned));
+  flags = (unsigned char *)arena->alloc(n+1);
+  memset(dom_pre, 0, (n+1)*sizeof(unsigned));
+  memset(dom_post, 0, (n+1)*sizeof(unsigned));
+  memset(depth, 0, (n+1)*sizeof(unsigned));
+  memset(flags, 0, n+1);
+  for (i=0; i<n; i++)
+    idom[i] = -1;
+
+  if (n == 0)
+    return;
+
+  po_num = (unsigned *)arena->alloc(n*sizeof(unsigned));
+  po_node = (unsigned *)arena->alloc(n*sizeof(unsigned));
+  doms = (unsigned *)arena->alloc(n*sizeof(unsigned));
+  stack = (unsigned *)arena->alloc(n*sizeof(unsigned));
+  cursor = (unsigned *)arena->alloc(n*sizeof(unsigned));
+
+  for (i=0; i<n; i++)
+    po_num[i] = UNSEEN;
+
+  // Postorder of the nodes reachable from the entry, by a depth-first walk
+  // with an explicit stack; cursor[x] is the next successor of x to visit
+  num_po = 0;
+  sp = 0;
+  stack[sp++] = graph->entry;
+  po_num[graph->entry] = ON_PATH;
+  cursor[graph->entry] = graph->succ_start[graph->entry];
+
+  while (sp > 0)
+  {
+    unsigned x = stack[sp-1];
+
+    if (cursor[x] < graph->succ_start[x+1])
+    {
+      unsigned s = graph->succ[cursor[x]++];
+
+      if (po_num[s] == UNSEEN)
+      {
+        po_num[s] = ON_PATH;
+        cursor[s] = graph->succ_start[s];
+        stack[sp++] = s;
+      }
+    }
+    else
+    {
+      sp--;
+      po_num[x] = num_po;
+      po_node[num_po++] = x;
+    }
+  }
+
+  // Iterate to the fixpoint in reverse postorder; doms[] holds the
+  // immediate dominators by postorder number, the entry being the last
+  for (i=0; i<num_po-1; i++)
+    doms[i] = UNSEEN;
+  doms[num_po-1] = num_po-1;
+
+  do
+  {
+    changed = false;
+
+    for (i=num_po-1; i-- > 0; )
+    {
+      unsigned x = po_node[i];
+      unsigned new_idom = UNSEEN;
+
+      for (k=graph->pred_start[x]; k<graph->pred_start[x+1]; k++)
+      {
+        unsigned p = po_num[graph->pred[k]];
+
+        // Unreachable predecessors and those not processed yet
+        if (p >= num_po || doms[p] == UNSEEN)
+          continue;
+        new_idom = (new_idom == UNSEEN) ? p : intersect(doms, p, new_idom);
+      }
+
+      if (doms[i] != new_idom)
+      {
+        doms[i] = new_idom;
+        changed = true;
+      }
+    }
+  } while (changed);
+
+  for (i=0; i<num_po-1; i++)
+    idom[po_node[i]] = po_node[doms[i]];
+
+  // Dominator tree, children grouped by their immediate dominator
+  child_start = (unsigned *)arena->alloc((n+1)*sizeof(unsigned));
+  child = (unsigned *)arena->alloc(n*sizeof(unsigned));
+  memset(child_start, 0, (n+1)*sizeof(unsigned));
+
+  for (i=0; i<n; i++)
+    if (idom[i] >= 0)
+      child_start[idom[i]+1]++;
+  for (i=0; i<n; i++)
+    child_start[i+1] += child_start[i];
+  memcpy(cursor, child_start, n*sizeof(unsigned));
+  for (i=0; i<n; i++)
+    if (idom[i] >= 0)
+      child[cursor[idom[i]]++] = i;
+
+  // Preorder and postorder numbers of the dominator tree, so that a
+  // dominance query is a test of interval inclusion
+  memcpy(cursor, child_start, n*sizeof(unsigned));
+  t = 0;
+  sp = 0;
+  stack[sp++] = graph->entry;
+  dom_pre[graph->entry] = ++t;
+
+  while (sp > 0)
+  {
+    unsigned x = stack[sp-1];
+
+    if (cursor[x] < child_start[x+1])
+    {
+      unsigned c = child[cursor[x]++];
+
+      dom_pre[c] = ++t;
+      stack[sp++] = c;
+    }
+    else
+    {
+      sp--;
+      dom_post[x] = ++t;
+    }
+  }
+}
+
+void LcuLoopFinder::find_natural_loops()
+{
+  unsigned n, h, i, k, sp, num_body;
+  unsigned *mark, *body, *work;
+
+  lcu_claim(graph != NULL, "natural loops need the dominators");
+  n = graph->num_nodes;
+
+  mark = (unsigned *)arena->alloc((n+1)*sizeof(unsigned));
+  body = (unsigned *)arena->alloc((n+1)*sizeof(unsigned));
+  work = (unsigned *)arena->alloc((n+1)*sizeof(unsigned));
+
+  memset(depth, 0, (n+1)*sizeof(unsigned));
+  memset(flags, 0, n+1);
+  for (i=0; i<n; i++)
+    mark[i] = UNSEEN;
+
+  // One loop per header; mark[x] == h for the nodes of the loop of h
+  for (h=0; h<n; h++)
+  {
+    if (!is_reachable(h))
+      continue;
+
+    num_body = 0;
+    sp = 0;
+
+    for (k=graph->pred_start[h]; k<graph->pred_start[h+1]; k++)
+    {
+      unsigned t = graph->pred[k];
+
+      if (!dominates(h, t))
+        continue;
+
+      flags[t] |= LOOP_END;
+      if (mark[h] != h)
+      {
+        mark[h] = h;
+        body[num_body++] = h;
+        flags[h] |= LOOP_BEGIN;
+      }
+      if (mark[t] != h)
+      {
+        mark[t] = h;
+        body[num_body++] = t;
+        work[sp++] = t;
+      }
+    }
+
+    // The walk back from the tails stops at the header
+    while (sp > 0)
+    {
+      unsigned x = work[--sp];
+
+      for (k=graph->pred_start[x]; k<graph->pred_start[x+1]; k++)
+      {
+        unsigned p = graph->pred[k];
+
+        if (mark[p] != h && is_reachable(p))
+        {
+          mark[p] = h;
+          body[num_body++] = p;
+          work[sp++] = p;
+        }
+      }
+    }
+
+    for (i=0; i<num_body; i++)
+    {
+      unsigned x = body[i];
+
+      depth[x]++;
+      for (k=graph->succ_start[x]; k<graph->succ_start[x+1]; k++)
+        if (mark[graph->succ[k]] != h)
+        {
+          flags[x] |= LOOP_EXIT;
+          break;
+        }
+    }
+  }
+}
+
+void LcuLoopFinder::print(LcuSink *out) const
+{
+  unsigned n;
+
+  out->put("Immediate dominators:\n");
+  out->put("  node idom\n");
+  for (n=0; n<graph->num_nodes; n++)
+    if (idom[n] >= 0)
+      out->print("%6u: %4d\n", n, idom[n]);
+
+  out->put("Loop info:\n");
+  out->put("  node depth begin end exit\n");
+  for (n=0; n<graph->num_nodes; n++)
+    out->print("%6u: %5u %5c %3c %4c\n", n, depth[n],
+               is_loop_begin(n) ? 'Y' : 'N', is_loop_end(n) ? 'Y' : 'N',
+               is_loop_exit(n) ? 'Y' : 'N');
+}
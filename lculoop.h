@@ -0,0 +1,108 @@
+/* file "tcfggen/lculoop.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCULOOP_H
+#define TCFGGEN_LCULOOP_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lculoop.h"
+#endif
+
+#include "tcfggen/lcuctx.h"
+#include "tcfggen/lcuinfo.h"
+#include "tcfggen/lcusink.h"
+
+
+/*
+ * LcuCfgGraph = snapshot of a CFG in compressed sparse row form, in arena
+ * storage. The successors of node n are succ[succ_start[n] ..
+ * succ_start[n+1]-1], in the order their edges were added; pred_start/pred
+ * hold the predecessors likewise. The nodes are numbered densely, from 0 to
+ * num_nodes-1.
+ */
+class LcuCfgGraph {
+  public:
+    LcuCfgGraph();
+
+    // Start a graph of num_nodes nodes and at most max_edges edges
+    void init(LcuArena *arena, unsigned num_nodes, unsigned max_edges);
+    void add_edge(unsigned from, unsigned to);
+
+    // Build the successor and predecessor arrays once all edges are added
+    void finish(unsigned entry);
+
+    unsigned num_nodes, num_edges;
+    unsigned entry;
+    unsigned *succ_start, *succ;
+    unsigned *pred_start, *pred;
+
+  protected:
+    LcuArena *arena;
+    unsigned max_edges;
+    unsigned *edge_from, *edge_to;
+};
+
+/*
+ * LcuLoopFinder = dominators (Cooper, Harvey and Kennedy, "A Simple, Fast
+ * Dominance Algorithm") and natural loops of an LcuCfgGraph, as the loop
+ * info that lcugen reads. The back edges of a loop header, i.e. the edges
+ * t -> h where h dominates t, make up a single loop; the loop body is found
+ * by walking the predecessors back from the tails t to h. A node is a loop
+ * begin if it heads a loop, a loop end if it is the tail of a back edge and
+ * a loop exit if it has a successor outside one of the loops it is in. The
+ * loop depth is the number of loops a node is in. Nodes unreachable from
+ * the entry have no dominator and are in no loop.
+ */
+class LcuLoopFinder : public LcuLoopInfo {
+  public:
+    LcuLoopFinder();
+
+    void find_dominators(LcuArena *arena, const LcuCfgGraph *graph);
+    void find_natural_loops();
+
+    // Immediate dominator, -1 for the entry and unreachable nodes
+    int  immed_dom(unsigned node) const { return idom[node]; }
+    bool is_reachable(unsigned node) const  { return dom_pre[node] != 0; }
+    bool dominates(unsigned a, unsigned b) const
+    {
+      return dom_pre[a] != 0 && dom_pre[b] != 0 &&
+             dom_pre[a] <= dom_pre[b] && dom_post[b] <= dom_post[a];
+    }
+
+    unsigned num_nodes() const          { return graph->num_nodes; }
+    int  loop_depth(unsigned node) const    { return depth[node]; }
+    bool is_loop_begin(unsigned node) const { return (flags[node] & LOOP_BEGIN) != 0; }
+    bool is_loop_end(unsigned node) const   { return (flags[node] & LOOP_END) != 0; }
+    bool is_loop_exit(unsigned node) const  { return (flags[node] & LOOP_EXIT) != 0; }
+
+    // Immediate dominators and the "Loop info" table, for the loop report
+    void print(LcuSink *out) const;
+
+  protected:
+    enum { LOOP_BEGIN = 1, LOOP_END = 2, LOOP_EXIT = 4 };
+
+    LcuArena *arena;
+    const LcuCfgGraph *graph;
+    int *idom;
+    // Dominator tree interval of each node (1-based, 0 if unreachable)
+    unsigned *dom_pre, *dom_post;
+    unsigned *depth;
+    unsigned char *flags;
+
+  private:
+    LcuLoopFinder(const LcuLoopFinder&);
+    LcuLoopFinder& operator=(const LcuLoopFinder&);
+};
+
+
+#endif /* TCFGGEN_LCULOOP_H */
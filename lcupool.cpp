@@ -0,0 +1,192 @@
+/* file "tcfggen/lcupool.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcupool.h"
+#endif
+
+#include "tcfggen/lcupool.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+
+LcuWorkPool::LcuWorkPool(int num_workers)
+{
+  int i;
+
+  if (num_workers < 1)
+    num_workers = 1;
+
+  pthread_mutex_init(&state_lock, NULL);
+  pthread_cond_init(&work_cv, NULL);
+  pthread_cond_init(&done_cv, NULL);
+  queued = 0;
+  pending = 0;
+  next_worker = 0;
+  shutdown = false;
+
+  for (i=0; i<num_workers; i++)
+  {
+    worker_t *w = new worker_t;
+
+    w->pool = this;
+    w->id = i;
+    pthread_mutex_init(&w->lock, NULL);
+    workers.push_back(w);
+  }
+
+  // Start the threads only after all deques exist, since any worker may
+  // try to steal from any other
+  for (i=0; i<num_workers; i++)
+  {
+    if (pthread_create(&workers[i]->thread, NULL, worker_main, workers[i]) != 0)
+    {
+      fprintf(stderr, "Error! Can not create worker thread %d.\n", i);
+      exit(1);
+    }
+  }
+}
+
+LcuWorkPool::~LcuWorkPool()
+{
+  unsigned i;
+
+  pthread_mutex_lock(&state_lock);
+  shutdown = true;
+  pthread_cond_broadcast(&work_cv);
+  pthread_mutex_unlock(&state_lock);
+
+  for (i=0; i<workers.size(); i++)
+    pthread_join(workers[i]->thread, NULL);
+
+  for (i=0; i<workers.size(); i++)
+  {
+    pthread_mutex_destroy(&workers[i]->lock);
+    delete workers[i];
+  }
+
+  pthread_cond_destroy(&done_cv);
+  pthread_cond_destroy(&work_cv);
+  pthread_mutex_destroy(&state_lock);
+}
+
+void LcuWorkPool::submit(job_fn fn, void *arg)
+{
+  job_t job;
+  worker_t *w;
+
+  job.fn = fn;
+  job.arg = arg;
+
+  // The job is pushed and published under state_lock, so that a worker
+  // never sees queued > 0 before the job can be found in a deque
+  pthread_mutex_lock(&state_lock);
+  w = workers[next_worker];
+  next_worker = (next_worker+1) % workers.size();
+
+  pthread_mutex_lock(&w->lock);
+  w->jobs.push_back(job);
+  pthread_mutex_unlock(&w->lock);
+
+  queued++;
+  pending++;
+  pthread_cond_signal(&work_cv);
+  pthread_mutex_unlock(&state_lock);
+}
+
+void LcuWorkPool::wait()
+{
+  pthread_mutex_lock(&state_lock);
+  while (pending > 0)
+    pthread_cond_wait(&done_cv, &state_lock);
+  pthread_mutex_unlock(&state_lock);
+}
+
+// Pop a job from the worker's own deque, or steal one from another worker
+bool LcuWorkPool::take_job(int id, job_t *job)
+{
+  unsigned n = workers.size();
+  unsigned k;
+  bool found = false;
+
+  for (k=0; k<n && !found; k++)
+  {
+    worker_t *w = workers[(id+k) % n];
+
+    pthread_mutex_lock(&w->lock);
+    if (!w->jobs.empty())
+    {
+      if (k == 0)
+      {
+        *job = w->jobs.back();
+        w->jobs.pop_back();
+      }
+      else
+      {
+        *job = w->jobs.front();
+        w->jobs.pop_front();
+      }
+      found = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+  }
+
+  if (found)
+  {
+    pthread_mutex_lock(&state_lock);
+    queued--;
+    pthread_mutex_unlock(&state_lock);
+  }
+
+  return found;
+}
+
+void *LcuWorkPool::worker_main(void *arg)
+{
+  worker_t *self = (worker_t *)arg;
+  LcuWorkPool *pool = self->pool;
+  job_t job;
+
+  while (true)
+  {
+    if (pool->take_job(self->id, &job))
+    {
+      job.fn(job.arg);
+
+      pthread_mutex_lock(&pool->state_lock);
+      pool->pending--;
+      if (pool->pending == 0)
+        pthread_cond_broadcast(&pool->done_cv);
+      pthread_mutex_unlock(&pool->state_lock);
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->state_lock);
+    while (pool->queued == 0 && !pool->shutdown)
+      pthread_cond_wait(&pool->work_cv, &pool->state_lock);
+    if (pool->queued == 0 && pool->shutdown)
+    {
+      pthread_mutex_unlock(&pool->state_lock);
+      break;
+    }
+    pthread_mutex_unlock(&pool->state_lock);
+  }
+
+  return NULL;
+}
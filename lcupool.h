@@ -0,0 +1,75 @@
+/* file "tcfggen/lcupool.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUPOOL_H
+#define TCFGGEN_LCUPOOL_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcupool.h"
+#endif
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+
+
+/*
+ * LcuWorkPool = fixed set of worker threads with one job deque per worker.
+ * Jobs are dealt round-robin; a worker runs its own jobs newest-first and,
+ * once its deque is empty, steals the oldest job of another worker.
+ */
+class LcuWorkPool {
+  public:
+    typedef void (*job_fn)(void *arg);
+
+    LcuWorkPool(int num_workers);
+    ~LcuWorkPool();
+
+    void submit(job_fn fn, void *arg);
+    void wait();                        // block until all jobs have run
+
+    int get_num_workers() const         { return (int)workers.size(); }
+
+  protected:
+    struct job_t {
+      job_fn fn;
+      void  *arg;
+    };
+
+    struct worker_t {
+      LcuWorkPool      *pool;
+      int               id;
+      pthread_t         thread;
+      pthread_mutex_t   lock;
+      std::deque<job_t> jobs;
+    };
+
+    static void *worker_main(void *arg);
+    bool take_job(int id, job_t *job);
+
+    std::vector<worker_t*> workers;
+    pthread_mutex_t state_lock;
+    pthread_cond_t  work_cv;            // signalled when jobs are queued
+    pthread_cond_t  done_cv;            // signalled when pending drops to 0
+    unsigned queued;                    // jobs sitting in some deque
+    unsigned pending;                   // jobs queued or running
+    unsigned next_worker;
+    bool     shutdown;
+
+  private:
+    LcuWorkPool(const LcuWorkPool&);
+    LcuWorkPool& operator=(const LcuWorkPool&);
+};
+
+
+#endif /* TCFGGEN_LCUPOOL_H */
@@ -0,0 +1,488 @@
+/* file "tcfggen/lcuside.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcuside.h"
+#endif
+
+#include "tcfggen/lcuside.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+// The records are read in place, so their layout must match the format
+typedef char side_header_size_check[sizeof(lcu_side_header) == 32 ? 1 : -1];
+typedef char side_unit_size_check[sizeof(lcu_side_unit) == 88 ? 1 : -1];
+typedef char side_task_size_check[sizeof(lcu_side_task) == 32 ? 1 : -1];
+typedef char side_loop_size_check[sizeof(lcu_side_loop) == 16 ? 1 : -1];
+typedef char side_edge_size_check[sizeof(task_edge) == 12 ? 1 : -1];
+typedef char side_tcfg_size_check[sizeof(tcfg_edge) == 16 ? 1 : -1];
+typedef char side_instr_size_check[sizeof(cfg_instr_pos) == 12 ? 1 : -1];
+
+
+void build_task_graph(LcuContext *ctx);
+void build_bb_task_index(LcuContext *ctx);
+
+
+static void put_u32(FILE *fp, unsigned long v)
+{
+  unsigned char b[4];
+  int i;
+
+  for (i=0; i<4; i++)
+    b[i] = (unsigned char)(v >> (8*i));
+  fwrite(b, 1, 4, fp);
+}
+
+static void put_u64(FILE *fp, unsigned long long v)
+{
+  unsigned char b[8];
+  int i;
+
+  for (i=0; i<8; i++)
+    b[i] = (unsigned char)(v >> (8*i));
+  fwrite(b, 1, 8, fp);
+}
+
+static bool host_is_little_endian()
+{
+  unsigned one = 1;
+  return *(unsigned char *)&one == 1;
+}
+
+
+LcuSidecarWriter::LcuSidecarWriter()
+{
+  fp = NULL;
+  pos = 0;
+}
+
+LcuSidecarWriter::~LcuSidecarWriter()
+{
+  close();
+}
+
+// The header is rewritten with the unit count and table offset by close()
+bool LcuSidecarWriter::open(const char *file_name)
+{
+  close();
+
+  fp = fopen(file_name, "wb");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "Error! Can not open sidecar file %s.\n", file_name);
+    return false;
+  }
+
+  units.clear();
+  pos = sizeof(lcu_side_header);
+  for (unsigned k=0; k<sizeof(lcu_side_header); k++)
+    fputc(0, fp);
+
+  return true;
+}
+
+void LcuSidecarWriter::align()
+{
+  while (pos % 8 != 0)
+  {
+    fputc(0, fp);
+    pos++;
+  }
+}
+
+void LcuSidecarWriter::add(LcuContext *ctx)
+{
+  lcu_side_unit u;
+  size_t name_len = strlen(ctx->proc_name);
+  unsigned k;
+
+  if (fp == NULL)
+    return;
+
+  memset(&u, 0, sizeof(u));
+  u.num_nodes = ctx->num_nodes;
+  u.num_tasks = ctx->i_max;
+  u.num_edges = ctx->edge_list_max;
+  u.num_tcfg = ctx->cac_task_id_max;
+  u.num_loops = ctx->nlp+1;
+  u.num_overhead = ctx->overhead_max;
+  u.fwdsel_max = ctx->fwdsel_max;
+  u.num_cfg_edges = ctx->num_cfg_edges;
+
+  u.name = pos;
+  fwrite(ctx->proc_name, 1, name_len+1, fp);
+  pos += name_len+1;
+  align();
+
+  u.tasks = pos;
+  for (k=0; k<u.num_tasks; k++)
+  {
+    task_data &t = ctx->task_data_arr[k];
+
+    put_u32(fp, t.taskid);
+    put_u32(fp, t.FSMsel);
+    put_u32(fp, t.fwdsel);
+    put_u32(fp, t.loop_addr);
+    put_u32(fp, t.inner_loop);
+    put_u32(fp, ctx->first_bb(k));
+    put_u32(fp, ctx->last_bb(k));
+    put_u32(fp, 0);
+  }
+  pos += (unsigned long long)u.num_tasks*sizeof(lcu_side_task);
+  align();
+
+  u.edges = pos;
+  for (k=0; k<u.num_edges; k++)
+  {
+    put_u32(fp, ctx->edge_list[k][0]);
+    put_u32(fp, ctx->edge_list[k][1]);
+    put_u32(fp, ctx->edge_list[k][2]);
+  }
+  pos += (unsigned long long)u.num_edges*sizeof(task_edge);
+  align();
+
+  u.tcfg = pos;
+  for (k=0; k<u.num_tcfg; k++)
+  {
+    put_u32(fp, ctx->TCFG[k].current_taskid);
+    put_u32(fp, ctx->TCFG[k].next_taskid);
+    put_u32(fp, ctx->TCFG[k].next_ttsel);
+    put_u32(fp, ctx->TCFG[k].next_loop_addr);
+  }
+  pos += (unsigned long long)u.num_tcfg*sizeof(tcfg_edge);
+  align();
+
+  u.loops = pos;
+  for (k=0; k<u.num_loops; k++)
+  {
+    put_u32(fp, ctx->loop_index_arr[k]);
+    put_u32(fp, ctx->loop_initial_arr[k]);
+    put_u32(fp, ctx->loop_step_arr[k]);
+    put_u32(fp, ctx->loop_final_arr[k]);
+  }
+  pos += (unsigned long long)u.num_loops*sizeof(lcu_side_loop);
+  align();
+
+  u.overhead = pos;
+  for (k=0; k<u.num_overhead; k++)
+  {
+    put_u32(fp, ctx->LoopOverheadInstr[k].bb_num);
+    put_u32(fp, ctx->LoopOverheadInstr[k].instr_num);
+    put_u32(fp, ctx->LoopOverheadInstr[k].istate);
+  }
+  pos += (unsigned long long)u.num_overhead*sizeof(cfg_instr_pos);
+  align();
+
+  u.depths = pos;
+  for (k=0; k<u.num_nodes; k++)
+    put_u32(fp, ctx->loop_depth_arr[k]);
+  pos += (unsigned long long)u.num_nodes*sizeof(unsigned);
+  align();
+
+  units.push_back(u);
+}
+
+void LcuSidecarWriter::close()
+{
+  unsigned long long table = pos;
+
+  if (fp == NULL)
+    return;
+
+  for (unsigned i=0; i<units.size(); i++)
+  {
+    lcu_side_unit &u = units[i];
+
+    put_u64(fp, u.name);
+    put_u64(fp, u.tasks);
+    put_u64(fp, u.edges);
+    put_u64(fp, u.tcfg);
+    put_u64(fp, u.loops);
+    put_u64(fp, u.overhead);
+    put_u64(fp, u.depths);
+    put_u32(fp, u.num_nodes);
+    put_u32(fp, u.num_tasks);
+    put_u32(fp, u.num_edges);
+    put_u32(fp, u.num_tcfg);
+    put_u32(fp, u.num_loops);
+    put_u32(fp, u.num_overhead);
+    put_u32(fp, u.fwdsel_max);
+    put_u32(fp, u.num_cfg_edges);
+  }
+
+  fseek(fp, 0, SEEK_SET);
+  fwrite(LCU_SIDE_MAGIC, 1, 8, fp);
+  put_u32(fp, LCU_SIDE_VERSION);
+  put_u32(fp, units.size());
+  put_u64(fp, table);
+  put_u32(fp, sizeof(lcu_side_header));
+  put_u32(fp, sizeof(lcu_side_unit));
+
+  fclose(fp);
+  fp = NULL;
+  units.clear();
+}
+
+
+LcuSidecarReader::LcuSidecarReader()
+{
+  data = NULL;
+  size = 0;
+  header = NULL;
+  unit_table = NULL;
+}
+
+bool LcuSidecarReader::is_sidecar(const char *file_name)
+{
+  return file_version(file_name) != 0;
+}
+
+unsigned LcuSidecarReader::file_version(const char *file_name)
+{
+  unsigned char hdr[12];
+  FILE *fp = fopen(file_name, "rb");
+  unsigned version = 0;
+
+  if (fp == NULL)
+    return 0;
+  if (fread(hdr, 1, 12, fp) == 12 && memcmp(hdr, LCU_SIDE_MAGIC, 8) == 0)
+    version = hdr[8] | hdr[9] << 8 | hdr[10] << 16 | (unsigned)hdr[11] << 24;
+  fclose(fp);
+
+  return version;
+}
+
+bool LcuSidecarReader::check_table(unsigned long long offset,
+                                   unsigned long long count,
+                                   size_t entry_size) const
+{
+  return offset % 8 == 0 && offset <= size &&
+         count <= (size - offset) / entry_size;
+}
+
+bool LcuSidecarReader::open(const char *file_name)
+{
+  struct stat st;
+  int fd;
+
+  close();
+
+  if (!host_is_little_endian())
+  {
+    fprintf(stderr, "Error! Sidecar files can only be mapped on little-endian hosts.\n");
+    return false;
+  }
+
+  fd = ::open(file_name, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0)
+  {
+    fprintf(stderr, "Error! Can not open sidecar file %s.\n", file_name);
+    if (fd >= 0)
+      ::close(fd);
+    return false;
+  }
+
+  size = st.st_size;
+  if (size >= sizeof(lcu_side_header))
+  {
+    void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (p != MAP_FAILED)
+      data = (const char *)p;
+  }
+  ::close(fd);
+
+  header = (const lcu_side_header *)data;
+  if (data != NULL && memcmp(header->magic, LCU_SIDE_MAGIC, 8) == 0 &&
+      header->version != LCU_SIDE_VERSION)
+  {
+    fprintf(stderr, "Error! Sidecar file %s has format version %u, "
+            "expected %u.\n", file_name, header->version, LCU_SIDE_VERSION);
+    close();
+    return false;
+  }
+  if (data == NULL ||
+      memcmp(header->magic, LCU_SIDE_MAGIC, 8) != 0 ||
+      header->header_size != sizeof(lcu_side_header) ||
+      header->unit_size != sizeof(lcu_side_unit) ||
+      !check_table(header->unit_table, header->num_units, sizeof(lcu_side_unit)))
+  {
+    fprintf(stderr, "Error! %s is not a valid sidecar file.\n", file_name);
+    close();
+    return false;
+  }
+
+  unit_table = (const lcu_side_unit *)(data + header->unit_table);
+
+  for (unsigned i=0; i<header->num_units; i++)
+  {
+    const lcu_side_unit &u = unit_table[i];
+
+    if (u.name >= size || memchr(data + u.name, '\0', size - u.name) == NULL ||
+        !check_table(u.tasks, u.num_tasks, sizeof(lcu_side_task)) ||
+        !check_table(u.edges, u.num_edges, sizeof(task_edge)) ||
+        !check_table(u.tcfg, u.num_tcfg, sizeof(tcfg_edge)) ||
+        !check_table(u.loops, u.num_loops, sizeof(lcu_side_loop)) ||
+        !check_table(u.overhead, u.num_overhead, sizeof(cfg_instr_pos)) ||
+        !check_table(u.depths, u.num_nodes, sizeof(unsigned)) ||
+        !check_ids(i))
+    {
+      fprintf(stderr, "Error! Unit %u of sidecar file %s is damaged.\n",
+              i, file_name);
+      close();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Whether the tables of unit i only refer to the tasks, loops and BBs it
+// has, so that load_unit can index the context tables with them. The BBs of
+// the tasks come in increasing, disjoint ranges.
+bool LcuSidecarReader::check_ids(unsigned i) const
+{
+  const lcu_side_unit &u = unit_table[i];
+  const lcu_side_task *tasks = get_tasks(i);
+  const task_edge *edges = get_edges(i);
+  const tcfg_edge *tcfg = get_tcfg(i);
+  const cfg_instr_pos *overhead = get_overhead(i);
+  int next_bb = 0;
+  unsigned k;
+
+  for (k=0; k<u.num_tasks; k++)
+  {
+    if (tasks[k].loop_addr >= u.num_loops)
+      return false;
+    if (tasks[k].first_bb < 0)
+      continue;
+    if (tasks[k].first_bb < next_bb || tasks[k].last_bb < tasks[k].first_bb ||
+        (unsigned)tasks[k].last_bb >= u.num_nodes)
+      return false;
+    next_bb = tasks[k].last_bb+1;
+  }
+
+  for (k=0; k<u.num_edges; k++)         // tail and head
+    if ((unsigned)edges[k][0] >= u.num_tasks ||
+        (unsigned)edges[k][1] >= u.num_tasks)
+      return false;
+
+  for (k=0; k<u.num_tcfg; k++)
+    if (tcfg[k].current_taskid >= u.num_tasks ||
+        tcfg[k].next_taskid >= u.num_tasks ||
+        tcfg[k].next_loop_addr >= u.num_loops)
+      return false;
+
+  for (k=0; k<u.num_overhead; k++)
+    if (overhead[k].bb_num >= u.num_nodes)
+      return false;
+
+  return true;
+}
+
+void LcuSidecarReader::close()
+{
+  if (data != NULL)
+    munmap((void *)data, size);
+  data = NULL;
+  size = 0;
+  header = NULL;
+  unit_table = NULL;
+}
+
+void LcuSidecarReader::load_unit(unsigned i, LcuContext *ctx) const
+{
+  const lcu_side_unit &u = unit_table[i];
+  const lcu_side_task *tasks = get_tasks(i);
+  const task_edge *edges = get_edges(i);
+  const tcfg_edge *tcfg = get_tcfg(i);
+  const lcu_side_loop *loops = get_loops(i);
+  const cfg_instr_pos *overhead = get_overhead(i);
+  const unsigned *depths = get_depths(i);
+  unsigned k;
+
+  ctx->reset(u.num_nodes);
+  ctx->set_proc_name(get_name(i));
+
+  // The tables are sized after num_nodes; a unit written by another
+  // version of the analysis may need more entries
+  ctx->task_data_arr.ensure(u.num_tasks+1);
+  ctx->task_enc_arr.ensure(u.num_tasks+1);
+  ctx->edge_list.ensure(u.num_edges);
+  ctx->TCFG.ensure(u.num_tcfg);
+  ctx->LoopOverheadInstr.ensure(u.num_overhead);
+  ctx->loop_index_arr.ensure(u.num_loops);
+  ctx->loop_initial_arr.ensure(u.num_loops);
+  ctx->loop_step_arr.ensure(u.num_loops);
+  ctx->loop_final_arr.ensure(u.num_loops);
+
+  for (k=0; k<u.num_nodes; k++)
+  {
+    ctx->bb_pool[k] = k;
+    ctx->loop_depth_arr[k] = depths[k];
+  }
+
+  for (k=0; k<u.num_tasks; k++)
+  {
+    task_data &t = ctx->task_data_arr[k];
+
+    t.taskid = tasks[k].taskid;
+    t.FSMsel = tasks[k].FSMsel;
+    t.fwdsel = tasks[k].fwdsel;
+    t.loop_addr = tasks[k].loop_addr;
+    t.inner_loop = tasks[k].inner_loop;
+
+    if (tasks[k].first_bb >= 0)
+    {
+      t.bb_list = &ctx->bb_pool[tasks[k].first_bb];
+      t.bb_list_size = tasks[k].last_bb - tasks[k].first_bb + 1;
+    }
+  }
+
+  for (k=0; k<u.num_edges; k++)
+    ctx->edge_list[k] = edges[k];
+  for (k=0; k<u.num_tcfg; k++)
+    ctx->TCFG[k] = tcfg[k];
+  for (k=0; k<u.num_loops; k++)
+  {
+    ctx->loop_index_arr[k] = loops[k].ixnum;
+    ctx->loop_initial_arr[k] = loops[k].initial;
+    ctx->loop_step_arr[k] = loops[k].step;
+    ctx->loop_final_arr[k] = loops[k].final;
+  }
+  for (k=0; k<u.num_overhead; k++)
+    ctx->LoopOverheadInstr[k] = overhead[k];
+
+  ctx->last_node_num = (u.num_nodes > 0) ? u.num_nodes-1 : 0;
+  ctx->i_max = u.num_tasks;
+  ctx->edge_list_max = u.num_edges;
+  ctx->cac_task_id_max = u.num_tcfg;
+  ctx->nlp = (u.num_loops > 0) ? u.num_loops-1 : 0;
+  ctx->overhead_max = u.num_overhead;
+  ctx->fwdsel_max = u.fwdsel_max;
+  ctx->num_cfg_edges = u.num_cfg_edges;
+
+  build_bb_task_index(ctx);
+  build_task_graph(ctx);
+}
@@ -0,0 +1,176 @@
+/* file "tcfggen/lcuside.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUSIDE_H
+#define TCFGGEN_LCUSIDE_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcuside.h"
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+#include <vector>
+
+#include "tcfggen/lcugen.h"
+#include "tcfggen/lcuctx.h"
+
+
+/*
+ * TCFG sidecar = binary file with the TCFG construction results of all the
+ * procedures of a run (-sidecar), laid out to be memory-mapped and read in
+ * place. All integers are little-endian, 32 bits unless noted, and every
+ * table starts at a multiple of 8 bytes:
+ *
+ *   header      lcu_side_header
+ *   per unit    name (NUL-terminated), then its tables:
+ *                 tasks     num_tasks    lcu_side_task
+ *                 edges     num_edges    task_edge   (task graph: tail,
+ *                                                     head, weight)
+ *                 tcfg      num_tcfg     tcfg_edge   (TCFG entries)
+ *                 loops     num_loops    lcu_side_loop (by loop address,
+ *                                                     0 is the procedure)
+ *                 overhead  num_overhead cfg_instr_pos
+ *                 depths    num_nodes    loop depth (by BB number)
+ *   unit table  num_units lcu_side_unit, at header.unit_table
+ *
+ * The unit table is written last, so a sidecar is only valid once its
+ * writer has been closed. A reader only accepts its own version: version 1
+ * had no depths table and an 80-byte unit record.
+ */
+
+#define LCU_SIDE_VERSION  2
+#define LCU_SIDE_MAGIC    "LCUSIDE"
+
+struct lcu_side_header {
+  char               magic[8];          // "LCUSIDE\0"
+  unsigned           version;
+  unsigned           num_units;
+  unsigned long long unit_table;        // file offset (64 bits)
+  unsigned           header_size;       // sizeof(lcu_side_header)
+  unsigned           unit_size;         // sizeof(lcu_side_unit)
+};
+
+struct lcu_side_unit {
+  unsigned long long name;              // file offsets (64 bits)
+  unsigned long long tasks;
+  unsigned long long edges;
+  unsigned long long tcfg;
+  unsigned long long loops;
+  unsigned long long overhead;
+  unsigned long long depths;
+  unsigned num_nodes;                   // CFG nodes (BBs)
+  unsigned num_tasks;
+  unsigned num_edges;
+  unsigned num_tcfg;
+  unsigned num_loops;
+  unsigned num_overhead;
+  unsigned fwdsel_max;
+  unsigned num_cfg_edges;               // 0 when unknown
+};
+
+struct lcu_side_task {
+  unsigned taskid;
+  int      FSMsel;                      // 0 for bwd, 1 for fwd tasks
+  unsigned fwdsel;
+  unsigned loop_addr;
+  unsigned inner_loop;
+  int      first_bb;                    // -1 for a task without BBs
+  int      last_bb;                     // the BBs of a task are consecutive
+  unsigned reserved;
+};
+
+struct lcu_side_loop {
+  int ixnum;                            // loop index register
+  int initial;
+  int step;
+  int final;
+};
+
+class LcuSidecarWriter {
+  public:
+    LcuSidecarWriter();
+    ~LcuSidecarWriter();
+
+    bool open(const char *file_name);
+    void add(LcuContext *ctx);          // a unit, once its notes are known
+    void close();                       // writes the unit table
+    bool is_open() const                { return fp != NULL; }
+
+  protected:
+    void align();
+
+    FILE *fp;
+    unsigned long long pos;
+    std::vector<lcu_side_unit> units;
+
+  private:
+    LcuSidecarWriter(const LcuSidecarWriter&);
+    LcuSidecarWriter& operator=(const LcuSidecarWriter&);
+};
+
+class LcuSidecarReader {
+  public:
+    LcuSidecarReader();
+    ~LcuSidecarReader()                 { close(); }
+
+    // Map a sidecar and check its header, unit table and the task, loop and
+    // BB ids of its units; false (with a message on stderr) for a bad one
+    bool open(const char *file_name);
+    void close();
+
+    // Whether a file starts like a sidecar, and the format version in its
+    // header (0 for another file)
+    static bool is_sidecar(const char *file_name);
+    static unsigned file_version(const char *file_name);
+
+    unsigned num_units() const          { return header->num_units; }
+    const lcu_side_unit &get_unit(unsigned i) const { return unit_table[i]; }
+
+    // The tables of a unit, in place
+    const char *get_name(unsigned i) const
+      { return data + unit_table[i].name; }
+    const lcu_side_task *get_tasks(unsigned i) const
+      { return (const lcu_side_task *)(data + unit_table[i].tasks); }
+    const task_edge *get_edges(unsigned i) const
+      { return (const task_edge *)(data + unit_table[i].edges); }
+    const tcfg_edge *get_tcfg(unsigned i) const
+      { return (const tcfg_edge *)(data + unit_table[i].tcfg); }
+    const lcu_side_loop *get_loops(unsigned i) const
+      { return (const lcu_side_loop *)(data + unit_table[i].loops); }
+    const cfg_instr_pos *get_overhead(unsigned i) const
+      { return (const cfg_instr_pos *)(data + unit_table[i].overhead); }
+    const unsigned *get_depths(unsigned i) const
+      { return (const unsigned *)(data + unit_table[i].depths); }
+
+    // Load unit i into ctx, as if it had just been analyzed: the tables
+    // for the emitters (lcugen_emit), the BB lists and loop depths
+    void load_unit(unsigned i, LcuContext *ctx) const;
+
+  protected:
+    bool check_table(unsigned long long offset, unsigned long long count,
+                     size_t entry_size) const;
+    bool check_ids(unsigned i) const;
+
+    const char *data;
+    size_t size;
+    const lcu_side_header *header;
+    const lcu_side_unit *unit_table;
+
+  private:
+    LcuSidecarReader(const LcuSidecarReader&);
+    LcuSidecarReader& operator=(const LcuSidecarReader&);
+};
+
+
+#endif /* TCFGGEN_LCUSIDE_H */
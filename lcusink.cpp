@@ -0,0 +1,326 @@
+/* file "tcfggen/lcusink.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcusink.h"
+#endif
+
+#include "tcfggen/lcusink.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+
+static char *alloc_buffer(char *old_buf, size_t size)
+{
+  char *p = (char *)realloc(old_buf, size);
+
+  if (p == NULL)
+  {
+    fprintf(stderr, "Error! Out of memory for the output buffer.\n");
+    exit(1);
+  }
+
+  return p;
+}
+
+// The buffer is only allocated when the sink is first opened, so idle sinks
+// (e.g. those of artifacts that are not requested) cost nothing
+LcuSink::LcuSink(size_t buf_size_in)
+{
+  fp = NULL;
+  in_memory = false;
+  pending_name = NULL;
+  written = false;
+  buf = NULL;
+  buf_size = (buf_size_in > 0) ? buf_size_in : 1;
+  used = 0;
+}
+
+LcuSink::~LcuSink()
+{
+  close();
+  free(buf);
+}
+
+bool LcuSink::open(const char *file_name, const char *mode)
+{
+  close();
+
+  if (buf == NULL)
+    buf = alloc_buffer(NULL, buf_size);
+
+  fp = fopen(file_name, mode);
+  if (fp == NULL)
+  {
+    fprintf(stderr, "Error! Can not open output file %s.\n", file_name);
+    return false;
+  }
+
+  return true;
+}
+
+void LcuSink::open_memory()
+{
+  close();
+
+  if (buf == NULL)
+    buf = alloc_buffer(NULL, buf_size);
+
+  in_memory = true;
+  used = 0;
+}
+
+void LcuSink::open_if_changed(const char *file_name)
+{
+  open_memory();
+
+  pending_name = strdup(file_name);
+  if (pending_name == NULL)
+  {
+    fprintf(stderr, "Error! Out of memory for the output buffer.\n");
+    exit(1);
+  }
+}
+
+void LcuSink::close()
+{
+  if (in_memory)
+  {
+    if (pending_name != NULL)
+    {
+      write_if_changed();
+      free(pending_name);
+      pending_name = NULL;
+    }
+
+    in_memory = false;
+    used = 0;
+    return;
+  }
+
+  if (fp == NULL)
+    return;
+
+  flush();
+  fclose(fp);
+  fp = NULL;
+}
+
+// Make room for size more bytes: a file sink writes out its buffer, a memory
+// sink grows it
+void LcuSink::make_room(size_t size)
+{
+  if (!in_memory)
+  {
+    flush();
+    return;
+  }
+
+  if (used + size > buf_size)
+  {
+    size_t new_size = buf_size;
+
+    while (used + size > new_size)
+      new_size *= 2;
+
+    buf = alloc_buffer(buf, new_size);
+    buf_size = new_size;
+  }
+}
+
+void LcuSink::print(const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  if (!is_open())
+    return;
+
+  va_start(ap, fmt);
+  n = vsnprintf(buf+used, buf_size-used, fmt, ap);
+  va_end(ap);
+
+  if (n < 0)
+    return;
+
+  if ((size_t)n < buf_size-used)
+  {
+    used += n;
+    return;
+  }
+
+  // Did not fit: make room and format again
+  make_room(n+1);
+
+  if ((size_t)n < buf_size-used)
+  {
+    va_start(ap, fmt);
+    vsnprintf(buf+used, buf_size-used, fmt, ap);
+    va_end(ap);
+    used += n;
+  }
+  else
+  {
+    char *tmp = (char *)malloc(n+1);
+
+    if (tmp == NULL)
+    {
+      fprintf(stderr, "Error! Out of memory for the output buffer.\n");
+      exit(1);
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(tmp, n+1, fmt, ap);
+    va_end(ap);
+
+    if (fp != NULL)
+      fwrite(tmp, 1, n, fp);
+    free(tmp);
+  }
+}
+
+void LcuSink::put(const char *s)
+{
+  write(s, strlen(s));
+}
+
+void LcuSink::put_uint(unsigned v)
+{
+  char digits[16];
+  char *p = digits + sizeof(digits);
+
+  do {
+    *--p = '0' + v%10;
+    v /= 10;
+  } while (v != 0);
+
+  write(p, digits + sizeof(digits) - p);
+}
+
+void LcuSink::put_hex(unsigned v)
+{
+  static const char hex_digits[] = "0123456789abcdef";
+  char digits[16];
+  char *p = digits + sizeof(digits);
+
+  do {
+    *--p = hex_digits[v & 0xf];
+    v >>= 4;
+  } while (v != 0);
+
+  write(p, digits + sizeof(digits) - p);
+}
+
+void LcuSink::write(const void *data, size_t size)
+{
+  if (!is_open())
+    return;
+
+  if (size > buf_size-used)
+  {
+    make_room(size);
+
+    // Large blocks bypass the buffer of a file sink
+    if (size > buf_size-used)
+    {
+      if (fp != NULL)
+        fwrite(data, 1, size, fp);
+      return;
+    }
+  }
+
+  memcpy(buf+used, data, size);
+  used += size;
+}
+
+void LcuSink::flush()
+{
+  if (in_memory)
+    return;
+
+  if (used > 0 && fp != NULL)
+    fwrite(buf, 1, used, fp);
+  used = 0;
+}
+
+// Whether a file holds exactly the given bytes
+static bool file_equals(const char *file_name, const char *data, size_t size)
+{
+  FILE *old_fp = fopen(file_name, "rb");
+  char chunk[16*1024];
+  size_t pos = 0;
+  size_t n;
+  bool equal = true;
+
+  if (old_fp == NULL)
+    return false;
+
+  while (equal && (n = fread(chunk, 1, sizeof(chunk), old_fp)) > 0)
+  {
+    equal = n <= size-pos && memcmp(chunk, data+pos, n) == 0;
+    pos += n;
+  }
+  fclose(old_fp);
+
+  return equal && pos == size;
+}
+
+void LcuSink::write_if_changed()
+{
+  char *tmp_name;
+  FILE *new_fp;
+  bool ok;
+
+  written = false;
+
+  if (file_equals(pending_name, buf, used))
+    return;
+
+  tmp_name = (char *)malloc(strlen(pending_name) + 32);
+  sprintf(tmp_name, "%s.%ld.tmp", pending_name, (long)getpid());
+
+  new_fp = fopen(tmp_name, "wb");
+  if (new_fp == NULL)
+  {
+    fprintf(stderr, "Error! Can not open output file %s.\n", tmp_name);
+    free(tmp_name);
+    return;
+  }
+
+  ok = fwrite(buf, 1, used, new_fp) == used;
+  ok = (fclose(new_fp) == 0) && ok;
+
+  if (ok && rename(tmp_name, pending_name) == 0)
+    written = true;
+  else
+  {
+    fprintf(stderr, "Error! Can not write output file %s.\n", pending_name);
+    remove(tmp_name);
+  }
+  free(tmp_name);
+}
+
+FILE *LcuSink::get_file()
+{
+  flush();
+  return fp;
+}
@@ -0,0 +1,100 @@
+/* file "tcfggen/lcusink.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUSINK_H
+#define TCFGGEN_LCUSINK_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcusink.h"
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+
+
+/*
+ * LcuSink = buffered output file for the generated artifacts and reports.
+ * Text is formatted into a large in-memory buffer and handed to the file in
+ * few large writes. The file is closed by close() or, at the latest, by the
+ * destructor.
+ * A sink opened with open_memory() keeps all the text in its (growing)
+ * buffer instead, e.g. for artifacts that end up in a bundle.
+ * A sink opened with open_if_changed() also collects the text in memory;
+ * close() then compares it against the current contents of the file and
+ * only rewrites the file if they differ, so that unchanged artifacts keep
+ * their modification time. The new contents go to a temporary file that is
+ * renamed over the old one, so an interrupted run never leaves a truncated
+ * artifact behind.
+ */
+class LcuSink {
+  public:
+    LcuSink(size_t buf_size = 64*1024);
+    ~LcuSink();
+
+    // Open file_name with the given fopen() mode; false if it can't be opened
+    bool open(const char *file_name, const char *mode = "w");
+    void open_memory();
+    void open_if_changed(const char *file_name);
+    void close();
+
+    // false if the last open_if_changed() sink found the file up to date
+    bool was_written() const            { return written; }
+    bool is_open() const                { return fp != NULL || in_memory; }
+
+    void print(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void put(const char *s);
+    void put(char c)
+    {
+      if (!is_open())
+        return;
+      if (used == buf_size)
+        make_room(1);
+      buf[used++] = c;
+    }
+    void write(const void *data, size_t size);
+
+    // Numbers as with %u and %x, without going through the printf machinery
+    void put_uint(unsigned v);
+    void put_hex(unsigned v);
+
+    // Hand the buffered text over to the file
+    void flush();
+
+    // Underlying file, for code that prints to a FILE* itself (e.g. the
+    // MachSUIF analysis printers). Buffered text is flushed first, so the
+    // output stays in order.
+    FILE *get_file();
+
+    // Text collected by a memory sink
+    const char *get_data() const        { return buf; }
+    size_t get_size() const             { return used; }
+
+  protected:
+    void make_room(size_t size);
+    void write_if_changed();
+
+    FILE  *fp;
+    bool   in_memory;
+    char  *pending_name;        // file of an open_if_changed() sink
+    bool   written;
+    char  *buf;
+    size_t buf_size;
+    size_t used;
+
+  private:
+    LcuSink(const LcuSink&);
+    LcuSink& operator=(const LcuSink&);
+};
+
+
+#endif /* TCFGGEN_LCUSINK_H */
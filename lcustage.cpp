@@ -0,0 +1,125 @@
+/* file "tcfggen/lcustage.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcustage.h"
+#endif
+
+#include "tcfggen/lcustage.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+
+LcuStage::LcuStage(int num_workers, unsigned capacity_in, item_fn fn_in, void *arg)
+{
+  if (num_workers < 1)
+    num_workers = 1;
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&work_cv, NULL);
+  pthread_cond_init(&space_cv, NULL);
+  pthread_cond_init(&done_cv, NULL);
+  capacity = (capacity_in > 0) ? capacity_in : 1;
+  pending = 0;
+  shutdown = false;
+  fn = fn_in;
+  fn_arg = arg;
+
+  threads.resize(num_workers);
+
+  for (int i=0; i<num_workers; i++)
+  {
+    if (pthread_create(&threads[i], NULL, worker_main, this) != 0)
+    {
+      fprintf(stderr, "Error! Can not create stage thread %d.\n", i);
+      exit(1);
+    }
+  }
+}
+
+LcuStage::~LcuStage()
+{
+  unsigned i;
+
+  // The workers drain the queue before they notice the shutdown
+  pthread_mutex_lock(&lock);
+  shutdown = true;
+  pthread_cond_broadcast(&work_cv);
+  pthread_mutex_unlock(&lock);
+
+  for (i=0; i<threads.size(); i++)
+    pthread_join(threads[i], NULL);
+
+  pthread_cond_destroy(&done_cv);
+  pthread_cond_destroy(&space_cv);
+  pthread_cond_destroy(&work_cv);
+  pthread_mutex_destroy(&lock);
+}
+
+void LcuStage::push(void *item)
+{
+  pthread_mutex_lock(&lock);
+  while (items.size() >= capacity)
+    pthread_cond_wait(&space_cv, &lock);
+
+  items.push_back(item);
+  pending++;
+  pthread_cond_signal(&work_cv);
+  pthread_mutex_unlock(&lock);
+}
+
+void LcuStage::wait()
+{
+  pthread_mutex_lock(&lock);
+  while (pending > 0)
+    pthread_cond_wait(&done_cv, &lock);
+  pthread_mutex_unlock(&lock);
+}
+
+void *LcuStage::worker_main(void *arg)
+{
+  LcuStage *stage = (LcuStage *)arg;
+  void *item;
+
+  pthread_mutex_lock(&stage->lock);
+
+  while (true)
+  {
+    while (stage->items.empty() && !stage->shutdown)
+      pthread_cond_wait(&stage->work_cv, &stage->lock);
+    if (stage->items.empty())
+      break;
+
+    item = stage->items.front();
+    stage->items.pop_front();
+    pthread_cond_signal(&stage->space_cv);
+    pthread_mutex_unlock(&stage->lock);
+
+    stage->fn(stage->fn_arg, item);
+
+    pthread_mutex_lock(&stage->lock);
+    stage->pending--;
+    if (stage->pending == 0)
+      pthread_cond_broadcast(&stage->done_cv);
+  }
+
+  pthread_mutex_unlock(&stage->lock);
+
+  return NULL;
+}
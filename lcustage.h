@@ -0,0 +1,63 @@
+/* file "tcfggen/lcustage.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUSTAGE_H
+#define TCFGGEN_LCUSTAGE_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcustage.h"
+#endif
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+
+
+/*
+ * LcuStage = background pipeline stage fed by a bounded FIFO queue.
+ * push() blocks while the queue holds capacity items, so a producer that
+ * runs ahead of the stage is held back. With a single worker the items are
+ * processed strictly in the order they were pushed.
+ */
+class LcuStage {
+  public:
+    typedef void (*item_fn)(void *arg, void *item);
+
+    LcuStage(int num_workers, unsigned capacity, item_fn fn, void *arg);
+    ~LcuStage();                        // runs the queued items, then stops
+
+    void push(void *item);
+    void wait();                        // block until all items have run
+
+  protected:
+    static void *worker_main(void *arg);
+
+    std::vector<pthread_t> threads;
+    std::deque<void*> items;
+    pthread_mutex_t lock;
+    pthread_cond_t  work_cv;            // signalled when an item is queued
+    pthread_cond_t  space_cv;           // signalled when an item is taken
+    pthread_cond_t  done_cv;            // signalled when pending drops to 0
+    unsigned capacity;
+    unsigned pending;                   // items queued or running
+    bool     shutdown;
+    item_fn  fn;
+    void    *fn_arg;
+
+  private:
+    LcuStage(const LcuStage&);
+    LcuStage& operator=(const LcuStage&);
+};
+
+
+#endif /* TCFGGEN_LCUSTAGE_H */
@@ -0,0 +1,255 @@
+/* file "tcfggen/lcutime.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/lcutime.h"
+#endif
+
+#include "tcfggen/lcutime.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+
+static const char *phase_names[LCU_PH_NUM] = {
+  "simplify",
+  "canonicalize",
+  "dominators",
+  "loops",
+  "lcugen",
+  "match",
+  "notes",
+  "encode",
+  "emit",
+  "emit_lut",
+  "emit_vcg",
+  "emit_fsm",
+  "emit_cac",
+  "graph",
+  "tcfg",
+  "cache"
+};
+
+const char *lcu_phase_name(int phase)
+{
+  return (phase >= 0 && phase < LCU_PH_NUM) ? phase_names[phase] : "?";
+}
+
+unsigned long long lcu_now_ns()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+
+LcuTrace::LcuTrace()
+{
+  file_name = NULL;
+  origin_ns = 0;
+  pthread_mutex_init(&lock, NULL);
+}
+
+LcuTrace::~LcuTrace()
+{
+  close();
+  pthread_mutex_destroy(&lock);
+}
+
+void LcuTrace::open(const char *file_name_in)
+{
+  close();
+
+  file_name = strdup(file_name_in);
+  origin_ns = lcu_now_ns();
+
+  // The opening thread is track 0
+  track_of_self();
+}
+
+int LcuTrace::track_of_self()
+{
+  pthread_t self = pthread_self();
+
+  for (unsigned t=0; t<tracks.size(); t++)
+    if (pthread_equal(tracks[t], self))
+      return t;
+
+  tracks.push_back(self);
+  return tracks.size()-1;
+}
+
+int LcuTrace::add_unit(const char *name)
+{
+  int id;
+
+  pthread_mutex_lock(&lock);
+  units.push_back(strdup(name));
+  id = units.size()-1;
+  pthread_mutex_unlock(&lock);
+
+  return id;
+}
+
+void LcuTrace::add(int unit, int phase, unsigned long long start_ns,
+                   unsigned long long dur_ns)
+{
+  event_t e;
+
+  e.unit = unit;
+  e.phase = phase;
+  e.start_ns = start_ns;
+  e.dur_ns = dur_ns;
+
+  pthread_mutex_lock(&lock);
+  e.track = track_of_self();
+  events.push_back(e);
+  pthread_mutex_unlock(&lock);
+}
+
+// Unit names are procedure names, but quote them properly all the same
+static void put_json_string(LcuSink *out, const char *s)
+{
+  out->put('"');
+  for (; *s != '\0'; s++)
+  {
+    if (*s == '"' || *s == '\\')
+      out->put('\\');
+    if ((unsigned char)*s < 0x20)
+      out->print("\\u%04x", (unsigned char)*s);
+    else
+      out->put(*s);
+  }
+  out->put('"');
+}
+
+void LcuTrace::close()
+{
+  LcuSink out;
+  unsigned k;
+
+  if (file_name == NULL)
+    return;
+
+  if (!out.open(file_name))
+    fprintf(stderr, "Error! Can not open trace file %s.\n", file_name);
+  else
+  {
+    out.put("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (k=0; k<tracks.size(); k++)
+    {
+      out.print("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":", k);
+      if (k == 0)
+        out.put("\"main\"");
+      else
+        out.print("\"worker %u\"", k);
+      out.put("}},\n");
+    }
+
+    for (k=0; k<events.size(); k++)
+    {
+      event_t &e = events[k];
+
+      out.print("{\"name\":\"%s\",\"cat\":\"tcfggen\",\"ph\":\"X\",\"pid\":1,"
+                "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"unit\":",
+                lcu_phase_name(e.phase), e.track,
+                (e.start_ns-origin_ns)/1000.0, e.dur_ns/1000.0);
+      put_json_string(&out, units[e.unit]);
+      out.put("}},\n");
+    }
+
+    // Closing metadata entry, so that no event is followed by a comma
+    out.put("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"args\":{\"name\":\"tcfggen\"}}\n]}\n");
+    out.close();
+  }
+
+  for (k=0; k<units.size(); k++)
+    free(units[k]);
+  units.clear();
+  events.clear();
+  tracks.clear();
+
+  free(file_name);
+  file_name = NULL;
+}
+
+
+void LcuTimes::clear(LcuTrace *trace_in, int unit_in)
+{
+  for (int p=0; p<LCU_PH_NUM; p++)
+  {
+    ns[p] = 0;
+    begin_ns[p] = 0;
+  }
+  trace = trace_in;
+  unit = unit_in;
+}
+
+void LcuTimes::stop(int phase)
+{
+  unsigned long long dur = lcu_now_ns() - begin_ns[phase];
+
+  ns[phase] += dur;
+  if (trace != NULL)
+    trace->add(unit, phase, begin_ns[phase], dur);
+}
+
+void LcuTimes::add(const LcuTimes &other)
+{
+  for (int p=0; p<LCU_PH_NUM; p++)
+    ns[p] += other.ns[p];
+}
+
+// The single emitter phases are part of LCU_PH_EMIT, the task graph and TCFG
+// phases part of LCU_PH_LCUGEN
+unsigned long long LcuTimes::get_total_ns() const
+{
+  unsigned long long total = 0;
+
+  for (int p=0; p<=LCU_PH_EMIT; p++)
+    total += ns[p];
+  return total + ns[LCU_PH_CACHE];
+}
+
+void LcuTimes::print(LcuSink *out) const
+{
+  bool first = true;
+
+  for (int p=0; p<LCU_PH_NUM; p++)
+  {
+    if (ns[p] == 0)
+      continue;
+    out->print("%s%s %.3f", first ? "" : ", ", lcu_phase_name(p), ns[p]/1e6);
+    first = false;
+  }
+  out->print("%stotal %.3f", first ? "" : ", ", get_total_ns()/1e6);
+}
+
+void LcuTimes::print_compact(LcuSink *out) const
+{
+  for (int p=0; p<LCU_PH_NUM; p++)
+    if (ns[p] != 0)
+      out->print(" %s=%.3f", lcu_phase_name(p), ns[p]/1e6);
+  out->print(" total=%.3f", get_total_ns()/1e6);
+}
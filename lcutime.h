@@ -0,0 +1,146 @@
+/* file "tcfggen/lcutime.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_LCUTIME_H
+#define TCFGGEN_LCUTIME_H
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/lcutime.h"
+#endif
+
+#include <pthread.h>
+#include <vector>
+
+#include "tcfggen/lcusink.h"
+
+
+// Phases of the processing of a unit
+enum {
+  LCU_PH_SIMPLIFY = 0,          // unreachable/merge/jump fixpoint loop
+  LCU_PH_CANONICALIZE,
+  LCU_PH_DOMINATORS,
+  LCU_PH_LOOPS,                 // natural loop analysis
+  LCU_PH_LCUGEN,                // task formation and TCFG construction
+  LCU_PH_MATCH,                 // loop overhead pattern matching
+  LCU_PH_NOTES,                 // note attachment
+  LCU_PH_ENCODE,                // task encodings for the emitters
+  LCU_PH_EMIT,                  // all the emitters
+  LCU_PH_EMIT_LUT,              // single emitters (traced runs only)
+  LCU_PH_EMIT_VCG,
+  LCU_PH_EMIT_FSM,
+  LCU_PH_EMIT_CAC,
+  LCU_PH_GRAPH,                 // parts of LCU_PH_LCUGEN: task graph,
+  LCU_PH_TCFG,                  // TCFG entries
+  LCU_PH_CACHE,                 // analysis cache lookup and store
+  LCU_PH_NUM
+};
+
+const char *lcu_phase_name(int phase);
+
+// Monotonic clock, in nanoseconds
+unsigned long long lcu_now_ns();
+
+
+/*
+ * LcuTrace = timeline of the phases of a run, written out as a Chrome
+ * trace_event JSON file (chrome://tracing, Perfetto). Every thread that
+ * records a phase gets a track of its own; the thread that opened the trace
+ * is the "main" track.
+ */
+class LcuTrace {
+  public:
+    LcuTrace();
+    ~LcuTrace();
+
+    void open(const char *file_name);
+    void close();                       // writes the file
+    bool is_open() const                { return file_name != NULL; }
+
+    // Register a unit, returns its id for add()
+    int add_unit(const char *name);
+    void add(int unit, int phase, unsigned long long start_ns,
+             unsigned long long dur_ns);
+
+  protected:
+    struct event_t {
+      int unit;
+      int phase;
+      int track;
+      unsigned long long start_ns;
+      unsigned long long dur_ns;
+    };
+
+    int track_of_self();
+
+    char *file_name;
+    unsigned long long origin_ns;
+    pthread_mutex_t lock;
+    std::vector<pthread_t> tracks;
+    std::vector<char*> units;
+    std::vector<event_t> events;
+
+  private:
+    LcuTrace(const LcuTrace&);
+    LcuTrace& operator=(const LcuTrace&);
+};
+
+/*
+ * LcuTimes = phase times of a unit. A phase may be entered more than once;
+ * its times add up. With a trace attached every phase is also recorded as
+ * a span of the timeline.
+ */
+class LcuTimes {
+  public:
+    LcuTimes()                          { clear(NULL, -1); }
+
+    void clear(LcuTrace *trace_in, int unit_in);
+    void start(int phase)               { begin_ns[phase] = lcu_now_ns(); }
+    void stop(int phase);
+
+    // Accumulate the times of another unit (run totals)
+    void add(const LcuTimes &other);
+
+    unsigned long long get_ns(int phase) const { return ns[phase]; }
+    unsigned long long get_total_ns() const;
+    bool is_traced() const              { return trace != NULL; }
+
+    // Print the times (in ms) as "phase t, phase t, ..."; phases that were
+    // never entered are left out
+    void print(LcuSink *out) const;
+
+    // Same, as " phase=t phase=t ... total=t" for the compact report
+    void print_compact(LcuSink *out) const;
+
+  protected:
+    unsigned long long ns[LCU_PH_NUM];
+    unsigned long long begin_ns[LCU_PH_NUM];
+    LcuTrace *trace;
+    int unit;
+};
+
+// Scoped timer of a phase
+class LcuPhaseTimer {
+  public:
+    LcuPhaseTimer(LcuTimes *times_in, int phase_in) : times(times_in), phase(phase_in)
+    {
+      times->start(phase);
+    }
+    ~LcuPhaseTimer()                    { times->stop(phase); }
+
+  protected:
+    LcuTimes *times;
+    int phase;
+};
+
+
+#endif /* TCFGGEN_LCUTIME_H */
@@ -0,0 +1,154 @@
+/* file "tcfggen/lcuunbundle.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+/* Description: Lists and unpacks the artifacts of a bundle written by
+ *              "do_tcfggen -bundle".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "tcfggen/lcubundle.h"
+
+
+static void print_usage()
+{
+  fprintf(stderr, "Usage: lcuunbundle [-l] [-d <dir>] <bundle> [<proc>[.<kind>] ...]\n");
+  fprintf(stderr, "  -l        list the artifacts of the bundle\n");
+  fprintf(stderr, "  -d <dir>  unpack into <dir> (default: current directory)\n");
+  fprintf(stderr, "  <proc>    unpack all the artifacts of procedure <proc>\n");
+  fprintf(stderr, "  <proc>.<kind>\n");
+  fprintf(stderr, "            unpack a single artifact (kind: lut, vcg, fsm, cac)\n");
+  fprintf(stderr, "With no <proc> arguments, all the artifacts are unpacked.\n");
+}
+
+static bool unpack(LcuBundleReader &bundle, unsigned i, const char *dir)
+{
+  const lcu_bundle_entry &e = bundle.get_entry(i);
+  std::string path;
+  FILE *outfile;
+  bool ok;
+
+  if (dir != NULL)
+  {
+    path = dir;
+    path += "/";
+  }
+  path += e.proc_name;
+  path += lcu_artifact_suffix(e.kind);
+
+  outfile = fopen(path.c_str(), "wb");
+  if (outfile == NULL)
+  {
+    fprintf(stderr, "Error! Can not open output file %s.\n", path.c_str());
+    return false;
+  }
+
+  ok = bundle.extract(i, outfile);
+  fclose(outfile);
+
+  if (!ok)
+    fprintf(stderr, "Error! Can not read %s from the bundle.\n", path.c_str());
+
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  LcuBundleReader bundle;
+  const char *dir = NULL;
+  bool list = false;
+  int errors = 0;
+  int a, k;
+  unsigned i;
+
+  for (a=1; a<argc && argv[a][0] == '-'; a++)
+  {
+    if (strcmp(argv[a], "-l") == 0)
+      list = true;
+    else if (strcmp(argv[a], "-d") == 0 && a+1 < argc)
+      dir = argv[++a];
+    else
+    {
+      print_usage();
+      return 1;
+    }
+  }
+
+  if (a >= argc)
+  {
+    print_usage();
+    return 1;
+  }
+
+  if (!bundle.open(argv[a]))
+    return 1;
+  a++;
+
+  if (list)
+  {
+    for (i=0; i<bundle.size(); i++)
+    {
+      const lcu_bundle_entry &e = bundle.get_entry(i);
+
+      printf("%s%s\t%llu\n", e.proc_name.c_str(), lcu_artifact_suffix(e.kind), e.size);
+    }
+    return 0;
+  }
+
+  // Unpack everything
+  if (a >= argc)
+  {
+    for (i=0; i<bundle.size(); i++)
+      if (!unpack(bundle, i, dir))
+        errors++;
+    return (errors > 0);
+  }
+
+  // Unpack the selected artifacts
+  for (; a<argc; a++)
+  {
+    std::string proc_name = argv[a];
+    const char *dot = strrchr(argv[a], '.');
+    int kind = (dot != NULL) ? lcu_artifact_kind_of(dot) : -1;
+    int found = 0;
+
+    if (kind != -1)
+      proc_name.erase(dot - argv[a]);
+
+    for (k=0; k<LCU_ART_NUM; k++)
+    {
+      int n;
+
+      if (kind != -1 && k != kind)
+        continue;
+
+      n = bundle.find(proc_name.c_str(), k);
+      if (n == -1)
+        continue;
+
+      found++;
+      if (!unpack(bundle, n, dir))
+        errors++;
+    }
+
+    if (found == 0)
+    {
+      fprintf(stderr, "Error! No artifact %s in the bundle.\n", argv[a]);
+      errors++;
+    }
+  }
+
+  return (errors > 0);
+}
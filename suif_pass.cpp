@@ -17,6 +17,9 @@
 #pragma implementation "tcfggen/suif_pass.h"
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <machine/pass.h>
 #include <machine/machine.h>
 #include <cfa/cfa.h>
@@ -28,7 +31,8 @@
 #define new D_NEW
 #endif
 
-IdString k_lix,k_dpt,k_dptt,k_loop,k_overhead;
+IdString k_lix,k_dpt,k_dptt,k_loop,k_overhead,k_tcfg_canon;
+IdString k_tcfg_task,k_tcfg_task_ref;
 
 extern "C" void
 init_tcfggen(SuifEnv *suif_env)
@@ -44,6 +48,9 @@ init_tcfggen(SuifEnv *suif_env)
     k_dptt = "dptt";
     k_loop = "loop";
     k_overhead = "overhead";
+    k_tcfg_canon = "tcfg_canon";
+    k_tcfg_task = "tcfg_task";
+    k_tcfg_task_ref = "tcfg_task_ref";
 
     ModuleSubSystem *mSubSystem = suif_env->get_module_subsystem();
     mSubSystem->register_module(new TcfgGenSuifPass(suif_env));
@@ -58,6 +65,7 @@ TcfgGenSuifPass::TcfgGenSuifPass(SuifEnv *suif_env, const IdString& name)
     : PipelinablePass(suif_env, name)
 {
     the_suif_env = suif_env;	// bind suif_env into our global environment
+    batch_units = false;
 }
 
 TcfgGenSuifPass::~TcfgGenSuifPass()
@@ -99,6 +107,21 @@ TcfgGenSuifPass::initialize()
     l->set_description("generate the initialization code of the task selection unit");
     flags->add(l);
 
+    l = new OptionList;
+    l->add(new OptionLiteral("-reproducible", &reproducible, true));
+    l->set_description("omit timestamps and only rewrite artifacts that change");
+    flags->add(l);
+
+    l = new OptionList;
+    l->add(new OptionLiteral("-validate_loops", &validate_loops, true));
+    l->set_description("check the dominators and natural loops against the MachSUIF analysis");
+    flags->add(l);
+
+    l = new OptionList;
+    l->add(new OptionLiteral("-compact_notes", &compact_notes, true));
+    l->set_description("attach a packed task note to the first BB of each task and task ids to the others");
+    flags->add(l);
+
     // -debug_proc procedure
     l = new OptionList;
     l->add(new OptionLiteral("-proc"));
@@ -107,6 +130,70 @@ TcfgGenSuifPass::initialize()
     l->add(proc_names);
     flags->add(l);
 
+    // -j threads
+    l = new OptionList;
+    l->add(new OptionLiteral("-j"));
+    num_threads = new OptionString("threads");
+    num_threads->set_description("form the tasks of independent procedures on this many threads");
+    l->add(num_threads);
+    flags->add(l);
+
+    // -emit_queue units
+    l = new OptionList;
+    l->add(new OptionLiteral("-emit_queue"));
+    emit_queue = new OptionString("units");
+    emit_queue->set_description("write the artifacts in the background, at most this many units behind (0: in line)");
+    l->add(emit_queue);
+    flags->add(l);
+
+    // -bundle file
+    l = new OptionList;
+    l->add(new OptionLiteral("-bundle"));
+    bundle_file = new OptionString("bundle file");
+    bundle_file->set_description("store the generated artifacts of all procedures in this file");
+    l->add(bundle_file);
+    flags->add(l);
+
+    // -report level
+    l = new OptionList;
+    l->add(new OptionLiteral("-report"));
+    report_level = new OptionString("level");
+    report_level->set_description("contents of loop_results.txt: none, summary, full (default) or compact");
+    l->add(report_level);
+    flags->add(l);
+
+    // -v level
+    l = new OptionList;
+    l->add(new OptionLiteral("-v"));
+    log_level = new OptionString("level");
+    log_level->set_description("diagnostics level: 0 errors, 1 warnings (default), 2 info, 3 debug, 4 trace");
+    l->add(log_level);
+    flags->add(l);
+
+    // -trace file
+    l = new OptionList;
+    l->add(new OptionLiteral("-trace"));
+    trace_file = new OptionString("trace file");
+    trace_file->set_description("write a Chrome trace_event timeline of the processing phases to this file");
+    l->add(trace_file);
+    flags->add(l);
+
+    // -sidecar file
+    l = new OptionList;
+    l->add(new OptionLiteral("-sidecar"));
+    sidecar_file = new OptionString("sidecar file");
+    sidecar_file->set_description("write the tasks, TCFG and loop parameters of all procedures to this binary file");
+    l->add(sidecar_file);
+    flags->add(l);
+
+    // -cache_dir directory
+    l = new OptionList;
+    l->add(new OptionLiteral("-cache_dir"));
+    cache_dir = new OptionString("cache directory");
+    cache_dir->set_description("reuse the analysis results of unchanged procedures from earlier runs kept in this directory");
+    l->add(cache_dir);
+    flags->add(l);
+
     // Accept tagged options in any order.
     _command_line->add(new OptionLoop(flags));
 
@@ -126,6 +213,9 @@ TcfgGenSuifPass::parse_command_line(TokenStream *command_line_stream)
     gen_vcg_file = false;
     gen_fsm_file = false;
     gen_cac_file = false;
+    reproducible = false;
+    validate_loops = false;
+    compact_notes = false;
     o_fname = empty_id_string;
 
     if (!PipelinablePass::parse_command_line(command_line_stream))
@@ -135,6 +225,9 @@ TcfgGenSuifPass::parse_command_line(TokenStream *command_line_stream)
     tcfggen.set_gen_vcg_file(gen_vcg_file);
     tcfggen.set_gen_fsm_file(gen_fsm_file);
     tcfggen.set_gen_cac_file(gen_cac_file);
+    tcfggen.set_reproducible(reproducible);
+    tcfggen.set_validate_loops(validate_loops);
+    tcfggen.set_compact_notes(compact_notes);
 
     int n = proc_names->get_number_of_values();
 
@@ -145,6 +238,69 @@ TcfgGenSuifPass::parse_command_line(TokenStream *command_line_stream)
 	cout << s.c_str() << endl;
     }
 
+    if (num_threads->get_number_of_values() > 0)
+    {
+	String s = num_threads->get_string(0)->get_string();
+	int n = atoi(s.c_str());
+	claim(n > 0, "-j expects a positive number of threads");
+	tcfggen.set_num_threads(n);
+    }
+
+    if (emit_queue->get_number_of_values() > 0)
+    {
+	String s = emit_queue->get_string(0)->get_string();
+	int n = atoi(s.c_str());
+	claim(n >= 0, "-emit_queue expects a non-negative number of units");
+	tcfggen.set_emit_queue(n);
+    }
+
+    if (bundle_file->get_number_of_values() > 0)
+    {
+	String s = bundle_file->get_string(0)->get_string();
+	tcfggen.set_bundle_file(s);
+    }
+
+    if (report_level->get_number_of_values() > 0)
+    {
+	String s = report_level->get_string(0)->get_string();
+	const char *r = s.c_str();
+
+	if (strcmp(r, "none") == 0)
+	    tcfggen.set_report(LCU_REPORT_NONE);
+	else if (strcmp(r, "summary") == 0)
+	    tcfggen.set_report(LCU_REPORT_SUMMARY);
+	else if (strcmp(r, "full") == 0)
+	    tcfggen.set_report(LCU_REPORT_FULL);
+	else if (strcmp(r, "compact") == 0)
+	    tcfggen.set_report(LCU_REPORT_COMPACT);
+	else
+	    claim(false, "-report expects none, summary, full or compact");
+    }
+
+    if (log_level->get_number_of_values() > 0)
+    {
+	String s = log_level->get_string(0)->get_string();
+	lcu_log_set_level(atoi(s.c_str()));
+    }
+
+    if (trace_file->get_number_of_values() > 0)
+    {
+	String s = trace_file->get_string(0)->get_string();
+	tcfggen.set_trace_file(s);
+    }
+
+    if (sidecar_file->get_number_of_values() > 0)
+    {
+	String s = sidecar_file->get_string(0)->get_string();
+	tcfggen.set_sidecar_file(s);
+    }
+
+    if (cache_dir->get_number_of_values() > 0)
+    {
+	String s = cache_dir->get_string(0)->get_string();
+	tcfggen.set_cache_dir(s);
+    }
+
     o_fname = process_file_names(file_names);
 
     return true;
@@ -153,8 +309,13 @@ TcfgGenSuifPass::parse_command_line(TokenStream *command_line_stream)
 void
 TcfgGenSuifPass::execute()
 {
+    batch_units = true;
     PipelinablePass::execute();
 
+    // Commit the units still queued for parallel processing
+    flush_pending();
+    batch_units = false;
+
     // Process the output file name, if any.
     if (!o_fname.is_empty())
         the_suif_env->write(o_fname.chars());
@@ -175,6 +336,9 @@ TcfgGenSuifPass::do_file_block(FileBlock *fb)
     claim(has_note(fb, k_target_lib),
 	  "expected target_lib annotation on file block");
 
+    // Units of the previous file block must be committed under its focus
+    flush_pending();
+
     focus(fb);
 
     tcfggen.initialize();
@@ -188,13 +352,41 @@ TcfgGenSuifPass::do_procedure_definition(ProcedureDefinition *pd)
 	return;
     }
 
+    // In a pipeline the next pass gets the procedure as soon as we return,
+    // so it is committed right away; only execute() queues the units
     focus(pd);
-    tcfggen.do_opt_unit(pd);
+    if (batch_units && tcfggen.get_num_threads() > 1)
+	tcfggen.prepare_opt_unit(pd);
+    else
+	tcfggen.do_opt_unit(pd);
     defocus(pd);
 }
 
+// Form the tasks of all queued units in parallel, then attach their notes
+// in the order the units were visited
+void
+TcfgGenSuifPass::flush_pending()
+{
+    if (tcfggen.pending_size() == 0)
+	return;
+
+    tcfggen.analyze_pending();
+
+    for (unsigned i = 0; i < tcfggen.pending_size(); i++)
+    {
+	OptUnit *unit = tcfggen.get_pending_unit(i);
+
+	focus(unit);
+	tcfggen.commit_pending(i);
+	defocus(unit);
+    }
+
+    tcfggen.clear_pending();
+}
+
 void
 TcfgGenSuifPass::finalize()
 {
+    flush_pending();
     tcfggen.finalize();
 }
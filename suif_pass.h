@@ -32,8 +32,20 @@ class TcfgGenSuifPass : public PipelinablePass {
 
     // command-line arguments
     bool gen_lut_file, gen_vcg_file, gen_fsm_file, gen_cac_file;
+    bool reproducible;
+    bool validate_loops;	// check the loop analysis against MachSUIF's
+    bool compact_notes;		// packed task notes (-compact_notes)
     OptionString *proc_names;
+    OptionString *num_threads;	// worker threads for task formation (-j)
+    OptionString *emit_queue;	// depth of the emission stage queue (-emit_queue)
+    OptionString *bundle_file;	// container for all the artifacts (-bundle)
+    OptionString *trace_file;	// timeline of the processing phases (-trace)
+    OptionString *sidecar_file;	// binary TCFG of all procedures (-sidecar)
+    OptionString *cache_dir;	// analysis results of earlier runs (-cache_dir)
+    OptionString *log_level;	// diagnostics level (-v)
+    OptionString *report_level;	// contents of the loop report (-report)
     OptionString *file_names;	// names of input and/or output files
+    bool batch_units;		// -j queues the units (run by execute())
     IdString o_fname;		// optional output file name
 
     set<IdString> out_procs;
@@ -52,6 +64,7 @@ class TcfgGenSuifPass : public PipelinablePass {
     void do_file_set_block(FileSetBlock*);
     void do_file_block(FileBlock*);
     void do_procedure_definition(ProcedureDefinition*);
+    void flush_pending();
 
     void finalize();
 };
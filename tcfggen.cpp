@@ -11,6 +11,9 @@
  *     the "machine/copyright.h" include file.
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <machine/copyright.h>
 
 #ifdef USE_PRAGMA_INTERFACE
@@ -22,7 +25,14 @@
 #include <cfa/cfa.h>
 
 #include "tcfggen/tcfggen.h"
+#include "tcfggen/tcfgnote.h"
 #include "tcfggen/lcugen.h"
+#include "tcfggen/lcuctx.h"
+#include "tcfggen/lcuinfo.h"
+#include "tcfggen/lculoop.h"
+#include "tcfggen/lcupool.h"
+#include "tcfggen/lcustage.h"
+#include "tcfggen/lcuside.h"
 #ifdef USE_DMALLOC
 #include <dmalloc.h>
 #define new D_NEW
@@ -33,51 +43,38 @@
 #define REMOVE       2
 
 
-void lcugen(NaturalLoopInfo nlinfo, Cfg *cfg_in);
-void sprint_data_task(char *outstr, int i);
-int get_loop_initialization_bb_num(task_data task_data_arr_in[100], unsigned int loop_num, unsigned int num_tasks);
-int get_max_loop_num(task_data task_data_arr_in[100], unsigned int num_tasks);
-int get_max_task_id(task_data task_data_arr_in[100], unsigned int num_tasks);
-int get_bb_task_num(task_data task_data_arr_in[100], unsigned int bb_num, unsigned int num_tasks);
-
+void lcugen_read_loop_info(LcuContext *ctx, const LcuLoopInfo &nlinfo);
+void lcugen(LcuContext *ctx);
+void lcugen_emit(LcuContext *ctx);
+void sprint_data_task(LcuContext *ctx, char *outstr, int i);
+int get_loop_initialization_bb_num(LcuContext *ctx, unsigned int loop_num);
+int get_max_loop_num(LcuContext *ctx);
+int get_max_task_id(LcuContext *ctx);
+int get_bb_task_num(LcuContext *ctx, unsigned int bb_num);
 
-extern task_data task_data_arr[100];
-extern tcfg_edge TCFG[100];
-extern cfg_instr_pos TaskEntryInstr[100],TaskExitInstr[100];
-extern cfg_instr_pos LoopOverheadInstr[100];
-extern unsigned node_end_arr[100];
-extern unsigned edge_list_max;        // number of unique task transition entries
-extern unsigned i_max;                // number of tasks
-extern unsigned cac_task_id_max;      // number of (redundant) task transition entries
-extern IdString k_lix, k_dpt, k_dptt, k_loop, k_overhead;
 
-const char *cur_proc_name;
-char *copied_cur_proc_name;
-bool gen_lut_file_g, gen_vcg_file_g, gen_fsm_file_g, gen_cac_file_g;
+extern IdString k_lix, k_dpt, k_dptt, k_loop, k_overhead, k_tcfg_canon;
+extern IdString k_tcfg_task, k_tcfg_task_ref;
 
 
-class LoopIndexNote : public Note {
+// The MachSUIF natural loop analysis results, as seen by lcugen
+class LcuNaturalLoopInfo : public LcuLoopInfo {
  public:
-    LoopIndexNote() : Note(note_list_any()) { }
-    LoopIndexNote(const LoopIndexNote &other) : Note(other) { }
-    LoopIndexNote(const Note &note) : Note(note) { }
-
-    int get_ixnum() const               { return _get_c_long(0); }
-    void set_ixnum(int ixnum)           { _replace(0, ixnum); }
-    IdString get_ixnum_str() const      { return _get_string(1); }
-    void set_ixnum_str(IdString lix_id) { _replace(1, lix_id); }
-    int get_task_id() const             { return _get_c_long(2); }
-    void set_task_id(int task_id)       { _replace(2, task_id); }
-    int get_ttsel() const               { return _get_c_long(3); }
-    void set_ttsel(int ttsel)           { _replace(3, ttsel); }
-    int get_fwdsel() const              { return _get_c_long(4); }
-    void set_fwdsel(int fwdsel)         { _replace(4, fwdsel); }
-    int get_loop_addr() const           { return _get_c_long(5); }
-    void set_loop_addr(int loop_addr)   { _replace(5, loop_addr); }
-    IdString get_task_enc() const       { return _get_string(6); }
-    void set_task_enc(IdString task_id) { _replace(6, task_id); }
+    LcuNaturalLoopInfo(NaturalLoopInfo *nlinfo_in, Cfg *cfg_in)
+      : nlinfo(nlinfo_in), cfg(cfg_in) { }
+
+    unsigned num_nodes() const           { return nodes_size(cfg); }
+    int  loop_depth(unsigned n) const    { return nlinfo->loop_depth(n); }
+    bool is_loop_begin(unsigned n) const { return nlinfo->is_loop_begin(n); }
+    bool is_loop_end(unsigned n) const   { return nlinfo->is_loop_end(n); }
+    bool is_loop_exit(unsigned n) const  { return nlinfo->is_loop_exit(n); }
+
+ protected:
+    NaturalLoopInfo *nlinfo;
+    Cfg *cfg;
 };
 
+
 /*
  * DpttNote = data-processing task transition note
  * Attach to the last instruction in a task
@@ -154,86 +151,972 @@ class OvrhdInstrNote : public Note {
     void set_istate(int istate)           { _replace(0, istate); }
 };
 
+/*
+ * CanonNote = structural fingerprint of a simplified and canonicalized CFG
+ * Attach to the CFG; lets a later run skip the simplification
+ */
+class CanonNote : public Note {
+ public:
+    CanonNote() : Note(note_list_any()) { }
+    CanonNote(const CanonNote &other) : Note(other) { }
+    CanonNote(const Note &note) : Note(note) { }
+
+    long get_fingerprint() const          { return _get_c_long(0); }
+    void set_fingerprint(long fp)         { _replace(0, fp); }
+    int get_num_nodes() const             { return _get_c_long(1); }
+    void set_num_nodes(int num_nodes)     { _replace(1, num_nodes); }
+};
+
+
+/*
+ * Facts about a CFG node, collected in the single walk over the CFG that
+ * precedes note attachment
+ */
+typedef struct tcfg_node_fact_t
+{
+    CfgNode *cnode;
+    int      number;
+    int      task;          // index in task_data_arr, -1 if in no task
+} tcfg_node_fact;
+
+// Notes of the tcfggen pseudo-instructions
+enum {
+    TCFG_NOTE_LIX = 0,      // LoopIndexNote, per BB of a task
+    TCFG_NOTE_DPT,          // DptNote, first BB of a task
+    TCFG_NOTE_LOOP,         // LoopNote, last BB of a bwd task
+    TCFG_NOTE_DPTT,         // DpttNote, per TCFG entry
+    TCFG_NOTE_OVERHEAD      // OvrhdInstrNote, per loop overhead instruction
+};
+
+/*
+ * A note to attach: the object it goes to, its kind and the entry of the
+ * context tables (task, TCFG entry or overhead instruction) holding its
+ * fields. The notes are collected as the analysis goes and materialized in
+ * a single batch at the end.
+ */
+typedef struct tcfg_note_ref_t
+{
+    IrObject *object;
+    int       kind;
+    int       index;
+} tcfg_note_ref;
+
+
+TcfgGen::TcfgGen()
+{
+    gen_lut_file = false;
+    gen_vcg_file = false;
+    gen_fsm_file = false;
+    gen_cac_file = false;
+    num_threads = 1;
+    reproducible = false;
+    emit_queue = 4;
+    report = LCU_REPORT_FULL;
+    validate_loops = false;
+    compact_notes = false;
+    loop_mismatches = 0;
+    simplify_mismatches = 0;
+    procedure_count = 0;
+    work_pool = NULL;
+    emit_stage = NULL;
+    pthread_mutex_init(&context_lock, NULL);
+    pthread_mutex_init(&times_lock, NULL);
+}
+
+TcfgGen::~TcfgGen()
+{
+    finalize();
+    pthread_mutex_destroy(&times_lock);
+    pthread_mutex_destroy(&context_lock);
+}
+
+void TcfgGen::initialize()
+{
+    // All the file blocks of the run share one bundle
+    if (!bundle_file_name.is_empty() && !bundle.is_open())
+      bundle.open(bundle_file_name.chars());
+
+    if (!trace_file_name.is_empty() && !trace.is_open())
+      trace.open(trace_file_name.chars());
+
+    if (!sidecar_file_name.is_empty() && !sidecar.is_open())
+      sidecar.open(sidecar_file_name.chars());
+
+    if (!cache_dir_name.is_empty() && !cache.is_open())
+      cache.open(cache_dir_name.chars());
+}
+
+void TcfgGen::finalize()
+{
+    // The pass commits its queued units under their focus; any left over
+    // are committed here, in order, rather than dropped
+    if (!pending_units.empty())
+    {
+      analyze_pending();
+      for (unsigned i=0; i<pending_units.size(); i++)
+        commit_pending(i);
+    }
+    clear_pending();
+
+    // Let the emission stage write out the units still queued
+    delete emit_stage;
+    emit_stage = NULL;
+
+    print_times();
+    print_cache_stats();
+
+    if (loop_mismatches > 0)
+      lcu_log(LCU_LOG_WARN, "The loop analysis differed from MachSUIF's in "
+              "%u of %d procedures\n", loop_mismatches, procedure_count);
+    if (simplify_mismatches > 0)
+      lcu_log(LCU_LOG_WARN, "%u of %d procedures that looked simplified "
+              "already could be simplified\n", simplify_mismatches,
+              procedure_count);
+
+    loop_report.close();
+    bundle.close();
+    trace.close();
+    sidecar.close();
+    cache.close();
+
+    lcu_log_flush();
+
+    delete work_pool;
+    work_pool = NULL;
+
+    for (unsigned i=0; i<free_contexts.size(); i++)
+      delete free_contexts[i];
+    free_contexts.clear();
+}
+
+LcuContext *TcfgGen::acquire_context()
+{
+    LcuContext *ctx = NULL;
+
+    pthread_mutex_lock(&context_lock);
+    if (!free_contexts.empty())
+    {
+      ctx = free_contexts.back();
+      free_contexts.pop_back();
+    }
+    pthread_mutex_unlock(&context_lock);
+
+    return (ctx != NULL) ? ctx : new LcuContext;
+}
+
+// Called by the emission stage as well, once a unit has been written out
+void TcfgGen::release_context(LcuContext *ctx)
+{
+    pthread_mutex_lock(&context_lock);
+    free_contexts.push_back(ctx);
+    pthread_mutex_unlock(&context_lock);
+}
+
+// Append the artifacts rendered for a unit to the bundle. The emission stage
+// runs a single worker when bundling, so the bundle follows the order of the
+// units.
+void TcfgGen::store_artifacts(LcuContext *ctx)
+{
+    if (!ctx->bundle_artifacts)
+      return;
+
+    for (int k=0; k<LCU_ART_NUM; k++)
+    {
+      LcuSink *buf = &ctx->artifact_buf[k];
+
+      if (buf->is_open())
+      {
+        bundle.add(ctx->proc_name, k, buf->get_data(), buf->get_size());
+        buf->close();
+      }
+    }
+}
+
+// Render the artifacts of a committed unit and recycle its context
+void TcfgGen::emit_unit(LcuContext *ctx)
+{
+    lcugen_emit(ctx);
+    store_artifacts(ctx);
+    record_times(ctx);
+    release_context(ctx);
+}
+
+void TcfgGen::emit_unit_job(void *self, void *ctx)
+{
+    ((TcfgGen *)self)->emit_unit((LcuContext *)ctx);
+}
+
+// Keep the phase times of a unit that has been written out
+void TcfgGen::record_times(LcuContext *ctx)
+{
+    unit_times_t u;
+
+    u.name = strdup(ctx->proc_name);
+    u.times = ctx->times;
+
+    pthread_mutex_lock(&times_lock);
+    unit_times.push_back(u);
+    run_times.add(ctx->times);
+    pthread_mutex_unlock(&times_lock);
+}
+
+// Append the phase times of each unit and of the run to the loop report.
+// Called once the emission stage has finished.
+void TcfgGen::print_times()
+{
+    if (unit_times.empty())
+      return;
+
+    if (loop_report.is_open() && report == LCU_REPORT_COMPACT)
+    {
+      for (unsigned i=0; i<unit_times.size(); i++)
+      {
+        loop_report.print("times proc=%s", unit_times[i].name);
+        unit_times[i].times.print_compact(&loop_report);
+        loop_report.put("\n");
+      }
+
+      loop_report.print("run procs=%u", (unsigned)unit_times.size());
+      run_times.print_compact(&loop_report);
+      loop_report.put("\n");
+    }
+    else if (loop_report.is_open())
+    {
+      loop_report.put("\n");
+      for (unsigned i=0; i<unit_times.size(); i++)
+      {
+        loop_report.print("Phase times (ms) of procedure \"%s\": ", unit_times[i].name);
+        unit_times[i].times.print(&loop_report);
+        loop_report.put("\n");
+      }
+
+      loop_report.print("Phase times (ms) of the run, %u procedures: ",
+                        (unsigned)unit_times.size());
+      run_times.print(&loop_report);
+      loop_report.put("\n");
+    }
+
+    for (unsigned i=0; i<unit_times.size(); i++)
+      free(unit_times[i].name);
+    unit_times.clear();
+    run_times.clear(NULL, -1);
+}
+
+// Statistics of the analysis cache, at the end of the loop report and on
+// stderr from -v 2 on
+void TcfgGen::print_cache_stats()
+{
+    LcuSink stats;
+
+    if (!cache.is_open())
+      return;
+
+    stats.open_memory();
+    cache.print_stats(&stats, false);
+    lcu_log(LCU_LOG_INFO, "%.*s", (int)stats.get_size(), stats.get_data());
+    stats.close();
+
+    if (loop_report.is_open())
+      cache.print_stats(&loop_report, report == LCU_REPORT_COMPACT);
+}
+
+// Summary of a unit in the loop report. The units are committed in order,
+// so the summaries follow the input.
+void TcfgGen::report_unit(LcuContext *ctx, int num_overhead)
+{
+    unsigned max_depth = 0;
+
+    if (!loop_report.is_open())
+      return;
+
+    for (unsigned n=0; n<=ctx->last_node_num; n++)
+      if (ctx->loop_depth_arr[n] > max_depth)
+        max_depth = ctx->loop_depth_arr[n];
+
+    if (report == LCU_REPORT_COMPACT)
+      loop_report.print("proc=%s bbs=%u loops=%u depth=%u tasks=%u edges=%u "
+                        "tcfg=%u overhead=%d\n",
+                        ctx->proc_name, ctx->num_nodes, ctx->nlp, max_depth,
+                        ctx->i_max, ctx->edge_list_max, ctx->cac_task_id_max,
+                        num_overhead);
+    else
+      loop_report.print("Procedure \"%s\": %u BBs, %u loops (depth %u), "
+                        "%u tasks, %u task transitions, %u TCFG entries, "
+                        "%d overhead instructions\n",
+                        ctx->proc_name, ctx->num_nodes, ctx->nlp, max_depth,
+                        ctx->i_max, ctx->edge_list_max, ctx->cac_task_id_max,
+                        num_overhead);
+}
+
+/*
+ * Pass a committed unit on to the emission stage. From here on the context
+ * is owned by the stage: the analysis never touches it again, so the stage
+ * reads the task and edge tables as an immutable snapshot without copying
+ * them. The stage queue holds at most emit_queue units; beyond that the
+ * analysis waits for the artifacts to be written.
+ */
+void TcfgGen::hand_off(LcuContext *ctx)
+{
+    if (emit_queue == 0)
+    {
+      emit_unit(ctx);
+      return;
+    }
+
+    if (emit_stage == NULL)
+      emit_stage = new LcuStage(bundle.is_open() ? 1 : num_threads,
+                                emit_queue, emit_unit_job, this);
+
+    emit_stage->push(ctx);
+}
 
 void TcfgGen::do_opt_unit(OptUnit *unit)
 {
-    OptUnit *cur_unit;
-    FILE *loop_report;
-    static int procedure_count = 0;
+    LcuContext *ctx = acquire_context();
+
+    prepare_unit(unit, ctx);
+    if (!ctx->cached)
+      lcugen(ctx);
+    commit_unit(unit, ctx);
+
+    hand_off(ctx);
+}
+
+/*
+ * Deferred processing (-j N). The MachSUIF-side work of each unit (CFG
+ * simplification, dominance and loop analysis, note attachment) is not
+ * thread-safe and stays on the calling thread: prepare_opt_unit() runs it
+ * up to the loop analysis, analyze_pending() forms the tasks of all queued
+ * units on the work pool, and commit_pending() attaches the notes, in the
+ * order the units were queued, and hands the unit to the emission stage.
+ */
+void TcfgGen::prepare_opt_unit(OptUnit *unit)
+{
+    LcuContext *ctx = acquire_context();
+
+    prepare_unit(unit, ctx);
+
+    pending_units.push_back(unit);
+    pending_contexts.push_back(ctx);
+}
+
+static void analyze_unit_job(void *arg)
+{
+    if (!((LcuContext *)arg)->cached)
+      lcugen((LcuContext *)arg);
+}
+
+void TcfgGen::analyze_pending()
+{
+    if (work_pool == NULL)
+      work_pool = new LcuWorkPool(num_threads);
+
+    for (unsigned i=0; i<pending_contexts.size(); i++)
+      work_pool->submit(analyze_unit_job, pending_contexts[i]);
+
+    work_pool->wait();
+}
+
+void TcfgGen::commit_pending(unsigned i)
+{
+    commit_unit(pending_units[i], pending_contexts[i]);
+
+    hand_off(pending_contexts[i]);
+    pending_contexts[i] = NULL;
+}
+
+void TcfgGen::clear_pending()
+{
+    for (unsigned i=0; i<pending_contexts.size(); i++)
+      if (pending_contexts[i] != NULL)
+        release_context(pending_contexts[i]);
+
+    pending_units.clear();
+    pending_contexts.clear();
+}
+
+static inline void fingerprint_add(unsigned long long *fp, int v)
+{
+    for (int b=0; b<4; b++, v >>= 8)
+    {
+      *fp ^= (unsigned char)v;
+      *fp *= 1099511628211ULL;
+    }
+}
+
+static inline int node_number(CfgNode *cnode)
+{
+    return (cnode != NULL) ? get_number(cnode) : -1;
+}
+
+// Kind of the control transfer instruction that ends a node (0 for none),
+// plus 8 if it is the only instruction apart from labels
+static int cti_kind(CfgNode *cnode)
+{
+    Instr *mi_cti = get_cti(cnode);
+    int kind;
+
+    if (mi_cti == NULL)
+      return 0;
+    else if (is_ubr(mi_cti))
+      kind = 1;
+    else if (is_cbr(mi_cti))
+      kind = 2;
+    else if (is_mbr(mi_cti))
+      kind = 3;
+    else if (is_return(mi_cti))
+      kind = 4;
+    else
+      kind = 5;
+
+    return (first_non_label(cnode) == mi_cti) ? kind+8 : kind;
+}
+
+/*
+ * Structural fingerprint (FNV-1a) of a CFG: its entry and exit nodes, and
+ * for each node in layout order whether it is empty, the kind of its CTI
+ * (and whether it just jumps on) and its fall-through and taken successors,
+ * i.e. all that the simplifiers and canonicalize() act upon. Other
+ * instructions are not covered, so the notes attached by an earlier run
+ * leave it unchanged.
+ */
+static unsigned long long cfg_fingerprint(Cfg *cfg)
+{
+    unsigned long long fp = 14695981039346656037ULL;
+
+    fingerprint_add(&fp, nodes_size(cfg));
+    fingerprint_add(&fp, node_number(get_entry_node(cfg)));
+    fingerprint_add(&fp, node_number(get_exit_node(cfg)));
+
+    for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+    {
+      CfgNode* cnode = get_node(cfg, cfg_nh);
+
+      fingerprint_add(&fp, get_number(cnode));
+      fingerprint_add(&fp, size(cnode) == 0);
+      fingerprint_add(&fp, cti_kind(cnode));
+      fingerprint_add(&fp, succs_size(cnode));
+      fingerprint_add(&fp, node_number(fall_succ(cnode)));
+      fingerprint_add(&fp, node_number(taken_succ(cnode)));
+    }
+
+    return fp;
+}
+
+static void string_hash_add(unsigned long long *fp, const char *s)
+{
+    for (; *s != '\0'; s++)
+    {
+      *fp ^= (unsigned char)*s;
+      *fp *= 1099511628211ULL;
+    }
+    fingerprint_add(fp, 0);
+}
+
+static void opnd_hash_add(unsigned long long *fp, Opnd opnd)
+{
+    fingerprint_add(fp, get_kind(opnd));
+
+    if (is_reg(opnd))
+      fingerprint_add(fp, get_reg(opnd));
+    else if (is_immed_integer(opnd))
+      fingerprint_add(fp, get_immed_int(opnd));
+    else if (is_var(opnd))
+      string_hash_add(fp, get_name(get_var(opnd)).chars());
+    else if (is_addr_sym(opnd))
+      string_hash_add(fp, get_name(get_sym(opnd)).chars());
+}
+
+/*
+ * Structural hash of a CFG, the key of the analysis cache (-cache_dir): its
+ * fingerprint and all the successors of each node, plus the opcode and
+ * operands of every instruction, which the loop pattern matching depends
+ * on. Registers and integer immediates are hashed by value, symbols by name
+ * and other operands by kind. Notes are not covered.
+ */
+static unsigned long long cfg_struct_hash(Cfg *cfg)
+{
+    unsigned long long fp = cfg_fingerprint(cfg);
+
+    fingerprint_add(&fp, LCU_SIDE_VERSION);
+
+    for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+    {
+      CfgNode* cnode = get_node(cfg, cfg_nh);
+
+      fingerprint_add(&fp, succs_size(cnode));
+      for (CfgNodeHandle h=succs_start(cnode); h!=succs_end(cnode); ++h)
+        fingerprint_add(&fp, get_number(*h));
+
+      fingerprint_add(&fp, size(cnode));
+      for (InstrHandle hi=instrs_start(cnode); hi!=instrs_end(cnode); ++hi)
+      {
+        Instr *mi = *hi;
+
+        fingerprint_add(&fp, get_opcode(mi));
+        fingerprint_add(&fp, srcs_size(mi));
+        fingerprint_add(&fp, dsts_size(mi));
+        for (int k=0; k<srcs_size(mi); k++)
+          opnd_hash_add(&fp, get_src(mi, k));
+        for (int k=0; k<dsts_size(mi); k++)
+          opnd_hash_add(&fp, get_dst(mi, k));
+      }
+    }
+
+    return fp;
+}
+
+// The k-th instruction of a BB, counting from 0
+static Instr *nth_instr(CfgNode *cnode, unsigned k)
+{
+    InstrHandle hi = instrs_start(cnode);
 
-    // Make local copy of the optimization unit
-    cur_unit = unit;
+    for (; k > 0 && hi != instrs_end(cnode); k--)
+      ++hi;
+    claim(hi != instrs_end(cnode), "instruction position out of range");
+    return *hi;
+}
 
+/*
+ * Whether the MachSUIF simplifiers may change the CFG. A worklist walk from
+ * the entry node visits every reachable node once and stops at the first one
+ * that a simplifier could act upon: the only predecessor of its only
+ * successor (merge_node_sequences), a jump to the next node in layout order
+ * or to a node that just jumps on (optimize_jumps). A node left unvisited is
+ * unreachable (remove_unreachable_nodes). The test errs on the safe side.
+ */
+bool TcfgGen::cfg_may_simplify(Cfg *cfg)
+{
+    CfgNode *entry = get_entry_node(cfg);
+    unsigned num_visited = 1;
+
+    node_seen.assign(nodes_size(cfg), 0);
+    node_work.clear();
+
+    node_seen[get_number(entry)] = 1;
+    node_work.push_back(entry);
+
+    while (!node_work.empty())
+    {
+      CfgNode *cnode = node_work.back();
+      Instr *mi_cti = get_cti(cnode);
+      node_work.pop_back();
+
+      if (succs_size(cnode) == 1)
+      {
+        CfgNode *succ = *succs_start(cnode);
+
+        if (succ != cnode && preds_size(succ) == 1)
+          return true;
+        if (mi_cti != NULL && is_ubr(mi_cti) && succ == get_layout_succ(cnode))
+          return true;
+      }
+
+      for (CfgNodeHandle h=succs_start(cnode); h!=succs_end(cnode); ++h)
+      {
+        CfgNode *succ = *h;
+        Instr *succ_cti = get_cti(succ);
+
+        if (mi_cti != NULL && succ_cti != NULL && is_ubr(succ_cti) &&
+            first_non_label(succ) == succ_cti)
+          return true;
+
+        if (!node_seen[get_number(succ)])
+        {
+          node_seen[get_number(succ)] = 1;
+          node_work.push_back(succ);
+          num_visited++;
+        }
+      }
+    }
+
+    return num_visited < (unsigned)nodes_size(cfg);
+}
+
+// Simplify the CFG of the unit and record its natural loop analysis
+void TcfgGen::prepare_unit(OptUnit *unit, LcuContext *ctx)
+{
     // Report name of the CFG under processing
-    cur_proc_name = get_name(cur_unit).chars();
-    dbg_printf("Processing CFG \"%s\"\n", cur_proc_name);
-    copied_cur_proc_name = (char *)malloc(48*sizeof(char *));
-    strcpy(copied_cur_proc_name,cur_proc_name);
+    const char *cur_proc_name = get_name(unit).chars();
+    lcu_log(LCU_LOG_INFO, "Processing CFG \"%s\"\n", cur_proc_name);
+
+    // Time the phases of the unit, on the timeline as well with -trace
+    if (trace.is_open())
+      ctx->times.clear(&trace, trace.add_unit(cur_proc_name));
+    else
+      ctx->times.clear(NULL, -1);
 
     // Get the body of the OptUnit
-    AnyBody *cur_body = get_body(cur_unit);
-//    AnyBody *cur_body = get_body(unit);
+    AnyBody *cur_body = get_body(unit);
 
     // verify that it is a CFG
     claim(is_kind_of<Cfg>(cur_body), "expected OptUnit body in Cfg form");
 
-    // Open loop analysis report file
-    if (procedure_count==0)
-    {
-      loop_report = fopen("loop_results.txt","w");
-    }
-    else
-      loop_report = fopen("loop_results.txt","a");
-      
-    gen_lut_file_g = gen_lut_file;
-    gen_vcg_file_g = gen_vcg_file;
-    gen_fsm_file_g = gen_fsm_file;
-    gen_cac_file_g = gen_cac_file;
+    // Open loop analysis report file; it stays open until finalize()
+    if (report != LCU_REPORT_NONE && !loop_report.is_open())
+      loop_report.open("loop_results.txt", (procedure_count==0) ? "w" : "a");
 
     // Create a local copy of the input CFG
     Cfg *cfg = (Cfg *)cur_body;
 
-    // Add a NOP to empty basic blocks
-    for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+    ctx->times.start(LCU_PH_SIMPLIFY);
+
+    // A CFG left canonical by an earlier run (and not changed since) needs
+    // neither simplification nor canonicalization
+    bool is_canonical = false;
+    if (has_note(cfg, k_tcfg_canon))
     {
-      // Get the current node
-      CfgNode* cnode = get_node(cfg, cfg_nh);
-//      Instr *mi_first;
+      CanonNote canon_note = get_note(cfg, k_tcfg_canon);
+
+      is_canonical = canon_note.get_num_nodes() == nodes_size(cfg) &&
+        (unsigned long long)canon_note.get_fingerprint() == cfg_fingerprint(cfg);
+      if (is_canonical)
+        dbg_printf("CFG \"%s\" is canonical already\n", cur_proc_name);
 
-      if (size(cnode) == 0)
+      // With -validate_loops the skip is checked as well: a CFG that a
+      // simplifier could still act upon is reported and processed again
+      if (is_canonical && validate_loops && cfg_may_simplify(cfg))
       {
-	// Append a NOP as the first instruction in the BB
-	append(cnode, new_instr_alm(suifrm::NOP));
+        lcu_log(LCU_LOG_ERROR, "Procedure \"%s\": the CFG is marked canonical "
+                "but can be simplified\n", cur_proc_name);
+        simplify_mismatches++;
+        is_canonical = false;
       }
     }
 
-    // Simplify the CFG
-    while (
-      remove_unreachable_nodes(cfg) ||
-      merge_node_sequences(cfg) ||
-      optimize_jumps(cfg)
-    )
+    if (!is_canonical)
     {
+      // Add a NOP to empty basic blocks
+      for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+      {
+        // Get the current node
+        CfgNode* cnode = get_node(cfg, cfg_nh);
+
+        if (size(cnode) == 0)
+        {
+          // Append a NOP as the first instruction in the BB
+          append(cnode, new_instr_alm(suifrm::NOP));
+        }
+      }
+
+      // Simplify the CFG; each of the simplifiers rescans all of it, so they
+      // only run when some node can be simplified. With -validate_loops they
+      // always run, and a CFG that they change against the test is reported.
+      bool may_simplify = cfg_may_simplify(cfg);
+
+      if (may_simplify || validate_loops)
+      {
+        bool simplified = false;
+
+        while (
+          remove_unreachable_nodes(cfg) ||
+          merge_node_sequences(cfg) ||
+          optimize_jumps(cfg)
+        )
+        {
+          simplified = true;
+        }
+
+        if (simplified && !may_simplify)
+        {
+          lcu_log(LCU_LOG_ERROR, "Procedure \"%s\": the CFG was simplified "
+                  "although no node seemed simplifiable\n", cur_proc_name);
+          simplify_mismatches++;
+        }
+      }
     }
 
-    canonicalize(cfg);
+    ctx->times.stop(LCU_PH_SIMPLIFY);
 
-    DominanceInfo temp_dom(cfg);
+    ctx->times.start(LCU_PH_CANONICALIZE);
+    if (!is_canonical)
+    {
+      CanonNote canon_note;
+
+      canonicalize(cfg);
+      canon_note.set_fingerprint((long)cfg_fingerprint(cfg));
+      canon_note.set_num_nodes(nodes_size(cfg));
+      set_note(cfg, k_tcfg_canon, canon_note);
+    }
+    ctx->times.stop(LCU_PH_CANONICALIZE);
+
+    // Per-procedure tables, sized after the CFG under processing
+    ctx->reset(nodes_size(cfg));
+    ctx->set_proc_name(cur_proc_name);
+    ctx->gen_lut_file = gen_lut_file;
+    ctx->gen_vcg_file = gen_vcg_file;
+    ctx->gen_fsm_file = gen_fsm_file;
+    ctx->gen_cac_file = gen_cac_file;
+    ctx->bundle_artifacts = bundle.is_open();
+    ctx->reproducible = reproducible;
+
+    for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+      ctx->num_cfg_edges += succs_size(get_node(cfg, cfg_nh));
+
+    // A CFG analyzed by an earlier run gets its tables from the cache and
+    // skips the loop analysis, task formation and pattern matching. With
+    // -validate_loops every unit is analyzed (and stored).
+    if (cache.is_open())
+    {
+      bool hit;
+
+      ctx->times.start(LCU_PH_CACHE);
+      ctx->cache_key = cfg_struct_hash(cfg);
+      hit = !validate_loops &&
+        cache.lookup(ctx->cache_key, nodes_size(cfg), ctx->num_cfg_edges, ctx);
+      ctx->times.stop(LCU_PH_CACHE);
+
+      if (hit)
+      {
+        dbg_printf("CFG \"%s\" found in the analysis cache\n", cur_proc_name);
+        procedure_count++;
+        return;
+      }
+    }
+
+    // Snapshot the CFG for the dominator and natural loop analysis
+    LcuCfgGraph graph;
+    LcuLoopFinder loops;
+
+    ctx->times.start(LCU_PH_DOMINATORS);
+    graph.init(&ctx->arena, nodes_size(cfg), ctx->num_cfg_edges);
+    for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+    {
+      CfgNode* cnode = get_node(cfg, cfg_nh);
+
+      for (CfgNodeHandle h=succs_start(cnode); h!=succs_end(cnode); ++h)
+        graph.add_edge(get_number(cnode), get_number(*h));
+    }
+    graph.finish(get_number(get_entry_node(cfg)));
 
     // Generate dominance info
+    loops.find_dominators(&ctx->arena, &graph);
+    ctx->times.stop(LCU_PH_DOMINATORS);
+
+    // Generate natural loop info
+    ctx->times.start(LCU_PH_LOOPS);
+    loops.find_natural_loops();
+    ctx->times.stop(LCU_PH_LOOPS);
+
+    // The dumps of a unit are headed by its name, for lcudriver
+    if (report == LCU_REPORT_FULL)
+    {
+      loop_report.print("Procedure \"%s\":\n", cur_proc_name);
+      loops.print(&loop_report);
+    }
+
+    if (validate_loops)
+      validate_unit_loops(ctx, cfg, loops);
+    else
+      lcugen_read_loop_info(ctx, loops);
+
+    procedure_count++;
+}
+
+/*
+ * -validate_loops: repeat the dominator and natural loop analysis of a unit
+ * with MachSUIF and compare the results node by node. On any difference the
+ * MachSUIF results are the ones used.
+ */
+void TcfgGen::validate_unit_loops(LcuContext *ctx, Cfg *cfg,
+                                  const LcuLoopFinder &loops)
+{
+    DominanceInfo temp_dom(cfg);
     temp_dom.find_dominators();
-    temp_dom.print(loop_report);
 
-    //NaturalLoopInfo temp_lnat(temp_dom) : dom_info(temp_dom), _depth(NULL), _loop(NULL);
     NaturalLoopInfo temp_lnat(&temp_dom);
-
-    // Generate natural loop info
     temp_lnat.find_natural_loops();
 
-    // Print natural loop info
-    temp_lnat.print(loop_report);
+    LcuNaturalLoopInfo nlinfo(&temp_lnat, cfg);
+    int entry_num = get_number(get_entry_node(cfg));
+    unsigned num_diffs = 0;
+
+    for (unsigned n=0; n<nlinfo.num_nodes(); n++)
+    {
+      CfgNode *dom = temp_dom.immed_dom(n);
+      int dom_num = (dom != NULL) ? get_number(dom) : -1;
+      bool same_dom = !loops.is_reachable(n) || (int)n == entry_num ||
+                      dom_num == loops.immed_dom(n);
+
+      if (same_dom &&
+          nlinfo.loop_depth(n) == loops.loop_depth(n) &&
+          nlinfo.is_loop_begin(n) == loops.is_loop_begin(n) &&
+          nlinfo.is_loop_end(n) == loops.is_loop_end(n) &&
+          nlinfo.is_loop_exit(n) == loops.is_loop_exit(n))
+        continue;
+
+      dbg_printf("BB #%u: idom %d depth %d %c%c%c, MachSUIF idom %d depth %d %c%c%c\n",
+                 n, loops.immed_dom(n), loops.loop_depth(n),
+                 loops.is_loop_begin(n) ? 'B' : '-',
+                 loops.is_loop_end(n) ? 'E' : '-',
+                 loops.is_loop_exit(n) ? 'X' : '-',
+                 dom_num, nlinfo.loop_depth(n),
+                 nlinfo.is_loop_begin(n) ? 'B' : '-',
+                 nlinfo.is_loop_end(n) ? 'E' : '-',
+                 nlinfo.is_loop_exit(n) ? 'X' : '-');
+      num_diffs++;
+    }
+
+    if (num_diffs > 0)
+    {
+      lcu_log(LCU_LOG_ERROR, "Procedure \"%s\": the loop analysis differs from "
+              "MachSUIF's in %u of %u BBs\n",
+              ctx->proc_name, num_diffs, nlinfo.num_nodes());
+      loop_mismatches++;
+      lcugen_read_loop_info(ctx, nlinfo);
+    }
+    else
+      lcugen_read_loop_info(ctx, loops);
+}
 
-    lcugen(temp_lnat, cfg);
+static inline void add_note_ref(tcfg_note_ref *notes, unsigned *notes_max,
+                                IrObject *object, int kind, int index)
+{
+    notes[*notes_max].object = object;
+    notes[*notes_max].kind = kind;
+    notes[*notes_max].index = index;
+    (*notes_max)++;
+}
+
+// Build the collected notes from the context tables and attach them. The
+// BBs of a task share its encoding, interned at its first BB, or with
+// -compact_notes packed into a TaskNote there.
+void TcfgGen::attach_notes(LcuContext *ctx, const tcfg_note_ref *notes,
+                           unsigned notes_max)
+{
+    bool compact = compact_notes;
+
+    // The fields of every task must fit the packed encoding
+    for (unsigned i=0; compact && i<ctx->i_max; i++)
+      if (!TcfgTask::fits(ctx->task_data_arr[i].taskid,
+                          ctx->task_data_arr[i].fwdsel,
+                          ctx->task_data_arr[i].loop_addr))
+      {
+        lcu_log(LCU_LOG_WARN, "Procedure \"%s\": task %u does not fit a compact "
+                "note, writing full notes\n", ctx->proc_name, i);
+        compact = false;
+      }
+
+    task_enc_ids.assign(ctx->i_max+1, IdString());
+
+    for (unsigned n=0; n<notes_max; n++)
+    {
+      IrObject *object = notes[n].object;
+      int i = notes[n].index;
+
+      switch (notes[n].kind)
+      {
+        case TCFG_NOTE_LIX:
+        {
+          int loop_id = ctx->task_data_arr[i].loop_addr;
+
+          if (compact && ctx->first_bb(i) == get_number((CfgNode *)object))
+          {
+            TcfgTask task;
+            TaskNote task_note;
+
+            task.task_id = ctx->task_data_arr[i].taskid;
+            task.ttsel = (ctx->task_data_arr[i].FSMsel != 0);
+            task.fwdsel = ctx->task_data_arr[i].fwdsel;
+            task.loop_addr = loop_id;
+            task_note.set_packed(task.pack());
+            task_note.set_ixnum(ctx->loop_index_arr[loop_id]);
+            set_note(object, k_tcfg_task, task_note);
+            break;
+          }
+          else if (compact)
+          {
+            TaskRefNote ref_note;
+
+            ref_note.set_task_id(ctx->task_data_arr[i].taskid);
+            set_note(object, k_tcfg_task_ref, ref_note);
+            break;
+          }
+
+          IdString &task_enc = task_enc_ids[i];
+          LoopIndexNote lix_note;
+
+          if (task_enc.is_empty())
+          {
+            char task_enc_str[32];
+            sprint_data_task(ctx, task_enc_str, i);
+            task_enc = IdString(task_enc_str);
+          }
+
+          lix_note.set_ixnum(ctx->loop_index_arr[loop_id]);
+          lix_note.set_task_id(ctx->task_data_arr[i].taskid);
+          lix_note.set_ttsel(ctx->task_data_arr[i].FSMsel);
+          lix_note.set_fwdsel(ctx->task_data_arr[i].fwdsel);
+          lix_note.set_loop_addr(loop_id);
+          lix_note.set_task_enc(task_enc);
+          set_note(object, k_lix, lix_note);
+
+          // dptt <task-enc> (<dpt-entry>), <task-id>, <ttsel>, <loop-addr>,<fwd-sel>
+          trc_printf("LoopInfoNote\t%s (%d), %d, %d, %d, v%d # @ BB%d\n",
+                     task_enc.chars(),
+                     ctx->task_data_arr[i].taskid,
+                     ctx->task_data_arr[i].FSMsel,
+                     loop_id,
+                     ctx->task_data_arr[i].fwdsel,
+                     ctx->loop_index_arr[loop_id],
+                     get_number((CfgNode *)object));
+          break;
+        }
+
+        case TCFG_NOTE_DPT:
+        {
+          DptNote dpt_note;
+
+          dpt_note.set_id(i);
+          dpt_note.set_first_bb(ctx->first_bb(i));
+          dpt_note.set_last_bb(ctx->last_bb(i));
+          set_note(object, k_dpt, dpt_note);
+          break;
+        }
+
+        case TCFG_NOTE_LOOP:
+        {
+          int loop_id = ctx->task_data_arr[i].loop_addr;
+          LoopNote loop_note;
+
+          loop_note.set_loop_addr(loop_id);
+          loop_note.set_ixnum(ctx->loop_index_arr[loop_id]);
+          loop_note.set_initial(ctx->loop_initial_arr[loop_id]);
+          loop_note.set_step(ctx->loop_step_arr[loop_id]);
+          loop_note.set_final(ctx->loop_final_arr[loop_id]);
+          set_note(object, k_loop, loop_note);
+          break;
+        }
+
+        case TCFG_NOTE_DPTT:
+        {
+          DpttNote dptt_note;
+
+          dptt_note.set_id(i);
+          dptt_note.set_current_taskid(ctx->TCFG[i].current_taskid);
+          dptt_note.set_next_taskid(ctx->TCFG[i].next_taskid);
+          dptt_note.set_next_ttsel(ctx->TCFG[i].next_ttsel);
+          dptt_note.set_next_loop_addr(ctx->TCFG[i].next_loop_addr);
+          set_note(object, k_dptt, dptt_note);
+          break;
+        }
+
+        case TCFG_NOTE_OVERHEAD:
+        {
+          OvrhdInstrNote ovhi_note;
+
+          ovhi_note.set_istate(ctx->LoopOverheadInstr[i].istate);
+          set_note(object, k_overhead, ovhi_note);
+          break;
+        }
+      }
+    }
+}
+
+// Match the loop overhead patterns and attach the tcfggen notes
+void TcfgGen::commit_unit(OptUnit *unit, LcuContext *ctx)
+{
+    Cfg *cfg = (Cfg *)get_body(unit);
 
     // Identify a looping instruction pattern in the current instruction list
     // NOTE: Currently, only looking for an add-ldc-blt pattern
@@ -242,30 +1125,57 @@ void TcfgGen::do_opt_unit(OptUnit *unit)
     Opnd rix,rfinal;
     int  cinitial,cstep,cfinal;
     bool is_looping_pattern_flag = false;
-    bool is_looping_pattern_flag_arr[250];
     bool is_loop_add=false,is_loop_ldc=false,is_loop_blt=false;
-    int loop_index_arr[100],loop_initial_arr[100],loop_step_arr[100],loop_final_arr[100];
     int LoopOverheadInstr_id=0;
 
-  loop_index_arr[0] = 0;
-  loop_initial_arr[0] = 0;
-  loop_step_arr[0] = 1;
-  loop_final_arr[0] = 0;
+    // The overhead instructions themselves, recorded along with their
+    // LoopOverheadInstr entries so that no positional lookup is needed
+    LcuTable<Instr*> overhead_instr;
+    overhead_instr.init(&ctx->arena, ctx->LoopOverheadInstr.get_capacity());
+
+    // Per-node facts, gathered in a single walk over the CFG and consumed
+    // by the final note attachment pass
+    tcfg_node_fact *facts =
+      (tcfg_node_fact *)ctx->arena.alloc(ctx->num_nodes*sizeof(tcfg_node_fact));
+    unsigned facts_max = 0;
+
+    ctx->times.start(LCU_PH_MATCH);
+
+  // The loop parameters and overhead instructions of a unit restored from
+  // the analysis cache are known; only the facts are gathered
+  if (!ctx->cached)
+  {
+    ctx->loop_index_arr[0] = 0;
+    ctx->loop_initial_arr[0] = 0;
+    ctx->loop_step_arr[0] = 1;
+    ctx->loop_final_arr[0] = 0;
+  }
 
   // Iterate through the nodes of the CFG
   for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
   {
     // Get the current node
     CfgNode* cnode = get_node(cfg, cfg_nh);
-    int local_loop_addr = task_data_arr[get_bb_task_num(task_data_arr,get_number(cnode),i_max)].loop_addr;
+    int cnode_num = get_number(cnode);
+    int bb_task_num = get_bb_task_num(ctx, cnode_num);
+    int local_loop_addr = (bb_task_num >= 0) ? ctx->task_data_arr[bb_task_num].loop_addr : 0;
+
+    claim(facts_max < ctx->num_nodes);
+    facts[facts_max].cnode = cnode;
+    facts[facts_max].number = cnode_num;
+    facts[facts_max].task = bb_task_num;
+    facts_max++;
+
+    if (ctx->cached)
+      continue;
 
     // if this is a loop-end and loop-exit CFG node (BB) then
     // it must contain the loop overhead instruction pattern
     // NOTE: This seems valid for well-structured (and optimized) SUIFvm code
 
-    if (temp_lnat.is_loop_end(cnode) && temp_lnat.is_loop_exit(cnode))
+    if (ctx->node_end_arr[cnode_num] == 1 && ctx->node_exit_arr[cnode_num] == 1)
     {
-      dbg_printf("BB #%d should contain a loop overhead instruction pattern\n",get_number(cnode));
+      trc_printf("BB #%d should contain a loop overhead instruction pattern\n",get_number(cnode));
 
       // Iterate through CfgNode cnode (current basic block)
       InstrHandle hk = instrs_start(cnode);
@@ -281,7 +1191,7 @@ void TcfgGen::do_opt_unit(OptUnit *unit)
 	//
 	if (get_opcode(mk) == suifrm::BLT)
 	{
-	  dbg_printf("Found a BLT in the looping pattern\n");
+	  trc_printf("Found a BLT in the looping pattern\n");
 	  is_loop_blt = true;
 
 	  // Get src0 operand of BLT
@@ -297,7 +1207,7 @@ void TcfgGen::do_opt_unit(OptUnit *unit)
 	  if (get_opcode(ml) == suifrm::LDC &&
 	      (get_dst(ml, 0) == rfinal))
 	  {
-	    dbg_printf("Found an LDC in the looping pattern\n");
+	    trc_printf("Found an LDC in the looping pattern\n");
 	    is_loop_ldc = true;
 
 	    // Access the predecessing instruction in cnode
@@ -310,23 +1220,23 @@ void TcfgGen::do_opt_unit(OptUnit *unit)
 	      cfinal = get_immed_int(get_src(ml, 0));
 
 	      if (is_loop_blt)
-	        loop_final_arr[local_loop_addr] = cfinal-1;
+	        ctx->loop_final_arr[local_loop_addr] = cfinal-1;
 	      else //if (is_loop_ble)
-	        loop_final_arr[local_loop_addr] = cfinal;
+	        ctx->loop_final_arr[local_loop_addr] = cfinal;
 	    }
 
 	    if (get_opcode(mi) == suifrm::ADD &&
 	        (get_dst(mi, 0) == rix) &&
 	        (get_src(mi, 0) == rix))
 	    {
-	      dbg_printf("Found an ADD in the looping pattern\n");
+	      trc_printf("Found an ADD in the looping pattern\n");
 	      is_loop_add = true;
 
 	      // Access cstep immed operand
 	      if (is_immed_integer(get_src(mi, 1)))
 	      {
 	        cstep = get_immed_int(get_src(mi, 1));
-	        loop_step_arr[local_loop_addr] = cstep;
+	        ctx->loop_step_arr[local_loop_addr] = cstep;
 	      }
 
 	      hk++;
@@ -349,130 +1259,92 @@ void TcfgGen::do_opt_unit(OptUnit *unit)
 //      lix_note.set_ixnum_str(IdString( reg_name(get_reg(rix)) ));
 //      lix_note.set_ixnum(ix_id);
 //      int local_loop_addr = task_data_arr[get_bb_task_num(task_data_arr,get_number(cnode),i_max)].loop_addr;
-      loop_index_arr[local_loop_addr] = get_reg(rix);
+      ctx->loop_index_arr[local_loop_addr] = get_reg(rix);
 
 //      fprintf(stdout,"Identified operand ");
 //      fprint(stdout,rix);
 //      fprintf(stdout," as loop index variable %d\n", local_loop_addr);
 
-      int cnode_num = get_number(cnode);
       int should_remove_blt=0;
 
       // Find out if the current task (which as we already know features a looping pattern)
       // consists solely of overhead instructions. If this is the case, the BLT should be
       // replaced by a NOP.
-      for (unsigned int i=0; i<i_max; i++)
+      if (bb_task_num >= 0 &&
+          ctx->first_bb(bb_task_num) != ctx->last_bb(bb_task_num))
       {
-        // if cnode is contained in this task
-        if (task_data_arr[i].bb_list[0] <= cnode_num && task_data_arr[i].bb_list[task_data_arr[i].bb_list_size-1] >= cnode_num)
-	{
-	  if (task_data_arr[i].bb_list[0] != task_data_arr[i].bb_list[task_data_arr[i].bb_list_size-1])
-	  {
-	    should_remove_blt = 1;
-	    break;
-	  }
-	}
+        should_remove_blt = 1;
       }
 
+      // The pattern closes the BB: blt, ldc and add are the last three
+      // instructions
+      InstrHandle h_ovrhd = instrs_end(cnode);
+
+      ctx->LoopOverheadInstr.ensure(LoopOverheadInstr_id+3);
+      overhead_instr.ensure(LoopOverheadInstr_id+3);
+
       // Update LoopOverheadInstr entry for this bwd task BB
       // if task_size > 3 then cti -> REMOVE else cti -> CONVERT
 //      if (size(cnode) > 3+1)
       if (should_remove_blt == 1)
       {
-        LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
-        LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-1;
-        LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-1;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
       }
       else
       {
-        LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
-        LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-1;
-        LoopOverheadInstr[LoopOverheadInstr_id].istate = CONVERT_NOP;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-1;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].istate = CONVERT_NOP;
       }
+      overhead_instr[LoopOverheadInstr_id] = *(--h_ovrhd);
       LoopOverheadInstr_id++;
       // add -> REMOVE
       //{
-        LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
-        LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-2;
-        LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-2;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
+        overhead_instr[LoopOverheadInstr_id] = *(--h_ovrhd);
       //}
       LoopOverheadInstr_id++;
 
       // ldc -> REMOVE
       //{
-        LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
-        LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-3;
-        LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode);
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].instr_num = size(cnode)-3;
+        ctx->LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
+        overhead_instr[LoopOverheadInstr_id] = *(--h_ovrhd);
       //}
       LoopOverheadInstr_id++;
     }
 
-    is_looping_pattern_flag_arr[get_number(cnode)] = is_looping_pattern_flag;
+    ctx->is_looping_pattern_flag_arr[get_number(cnode)] = is_looping_pattern_flag;
     is_looping_pattern_flag = false;
 
     is_loop_add = false;
     is_loop_ldc = false;
     is_loop_blt = false;
-
-  }
-
-  // Iterate through the nodes of the CFG
-  for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
-  {
-    // Get the current node
-    CfgNode* cnode = get_node(cfg, cfg_nh);
-
-    unsigned int i,j;
-
-      for (i=0; i<i_max; i++)
-      {
-        for (j=0; j<task_data_arr[i].bb_list_size; j++)
-	{
-	  if (task_data_arr[i].bb_list[j] == get_number(cnode))
-	  {
-            LoopIndexNote lix_note;
-
-            lix_note.set_ixnum(loop_index_arr[task_data_arr[i].loop_addr]);
-	    lix_note.set_task_id(task_data_arr[i].taskid);
-	    lix_note.set_ttsel(task_data_arr[i].FSMsel);
-	    lix_note.set_fwdsel(task_data_arr[i].fwdsel);
-	    lix_note.set_loop_addr(task_data_arr[i].loop_addr);
-
-	    char *task_enc_str = new char[20];
-	    sprint_data_task(task_enc_str, i);
-	    lix_note.set_task_enc(IdString( task_enc_str ));
-
-            set_note(cnode, k_lix, lix_note);
-	  }
-	}
-      }
   }
 
   // Identify the cinitial constant (loop initial parameter) for each loop in
-  // the given CFG
-  for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+  // the given CFG. The loop index registers are only known once all the
+  // overhead patterns have been matched.
+  for (unsigned f=0; f<facts_max && !ctx->cached; f++)
   {
-    // Get the current node
-    CfgNode* cnode = get_node(cfg, cfg_nh);
-    int cnode_num = get_number(cnode);
-
-    // Examine note
-    if (has_note(cnode, k_lix))
-    {
-    LoopIndexNote lix_note_read = get_note(cnode, k_lix);
-    claim(!is_null(lix_note_read));
-
-//    fprintf(stdout,"ttsel=%d\ttask_id=%d\tnode_end=%d\n",
-//    lix_note_read.get_ttsel(), lix_note_read.get_task_id(), node_end_arr[cnode_num]);
+    int i = facts[f].task;
 
     // if this is the end and exit block of a bwd task
-    if (lix_note_read.get_ttsel() == 0 &&
-        node_end_arr[cnode_num] == 1)
+    if (i >= 0 &&
+        ctx->task_data_arr[i].FSMsel == 0 &&
+        ctx->node_end_arr[facts[f].number] == 1)
     {
-      int cnode_loopinit_num = get_loop_initialization_bb_num(task_data_arr, lix_note_read.get_loop_addr(), i_max);
+      int loop_addr = ctx->task_data_arr[i].loop_addr;
+      int ixnum = ctx->loop_index_arr[loop_addr];
+      int cnode_loopinit_num = get_loop_initialization_bb_num(ctx, loop_addr);
 
-      dbg_printf("BB #%d contains the loop initialization of loop_addr %d\n",
-      cnode_loopinit_num, lix_note_read.get_loop_addr());
+      trc_printf("BB #%d contains the loop initialization of loop_addr %d\n",
+      cnode_loopinit_num, loop_addr);
 
       CfgNode* cnode_loopinit = get_node(cfg, cnode_loopinit_num);
 
@@ -492,20 +1364,24 @@ void TcfgGen::do_opt_unit(OptUnit *unit)
 	  claim(is_immed_integer(get_src(mk, 0)));
 	  cinitial = get_immed_int(get_src(mk, 0));
 
-          dbg_printf("ixnum=%d\tldc_dst0=%d\n",lix_note_read.get_ixnum(),get_reg(get_dst(mk,0)));
+          trc_printf("ixnum=%d\tldc_dst0=%d\n",ixnum,get_reg(get_dst(mk,0)));
 
       	  // check if the destination register of the LDC is the loop index register
-	  if (lix_note_read.get_ixnum() == get_reg(get_dst(mk, 0)))
+	  if (ixnum == get_reg(get_dst(mk, 0)))
 	  {
-	    dbg_printf("Found a loop initialization pattern\n");
+	    trc_printf("Found a loop initialization pattern\n");
 
-	    loop_initial_arr[lix_note_read.get_loop_addr()] = cinitial;
+	    ctx->loop_initial_arr[loop_addr] = cinitial;
 
-            // ldc -> REMOVE
+            // ldc -> REMOVE; the scan runs for every end BB of the loop, and
+            // a loop initialization BB may hold several such LDCs
+            ctx->LoopOverheadInstr.ensure(LoopOverheadInstr_id+1);
+            overhead_instr.ensure(LoopOverheadInstr_id+1);
             {
-              LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode_loopinit);
-              LoopOverheadInstr[LoopOverheadInstr_id].instr_num = m;
-              LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
+              ctx->LoopOverheadInstr[LoopOverheadInstr_id].bb_num = get_number(cnode_loopinit);
+              ctx->LoopOverheadInstr[LoopOverheadInstr_id].instr_num = m;
+              ctx->LoopOverheadInstr[LoopOverheadInstr_id].istate = REMOVE;
+              overhead_instr[LoopOverheadInstr_id] = mk;
             }
             LoopOverheadInstr_id++;
 	  }
@@ -514,219 +1390,125 @@ void TcfgGen::do_opt_unit(OptUnit *unit)
 	m++;
       }
     }
-    }
   }
 
-  dbg_printf("\n");
-
-  // Iterate through the nodes of the CFG
-  for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+  // The overhead instructions of a cached unit, by their positions
+  if (ctx->cached)
   {
-    // Get the current node
-    CfgNode* cnode = get_node(cfg, cfg_nh);
-
-    // Examine note
-    if (has_note(cnode, k_lix))
-    {
-    LoopIndexNote lix_note_read = get_note(cnode, k_lix);
-    claim(!is_null(lix_note_read));
-
-    // dptt <task-enc> (<dpt-entry>), <task-id>, <ttsel>, <loop-addr>,<fwd-sel>
-    dbg_printf("LoopInfoNote\t%s (%d), %d, %d, %d, v%d # @ BB%d\n",
-            lix_note_read.get_task_enc().chars(),
-	    lix_note_read.get_task_id(),
-	    lix_note_read.get_ttsel(),
-	    lix_note_read.get_loop_addr(),
-	    lix_note_read.get_fwdsel(),
-	    lix_note_read.get_ixnum(),
-	    get_number(cnode));
-    }
-  }
-
-  for (unsigned int i=0; i<i_max; i++)
-  {
-    // dpti <entry-num>, <first-bb-num>, <last-bb-num>
-    dbg_printf(".dpti\t%d, %d, %d\n",
-            i,
-            task_data_arr[i].bb_list[0],
-	    task_data_arr[i].bb_list[task_data_arr[i].bb_list_size-1]);
+    for (unsigned k=0; k<ctx->overhead_max; k++)
+      overhead_instr[k] = nth_instr(get_node(cfg, (int)ctx->LoopOverheadInstr[k].bb_num),
+                                    ctx->LoopOverheadInstr[k].instr_num);
+    LoopOverheadInstr_id = ctx->overhead_max;
   }
 
-  // Attach a DptNote to the first instruction of each data-processing task
-  for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
-  {
-    // Get the current node
-    CfgNode* cnode = get_node(cfg, cfg_nh);
-    int cnode_num = get_number(cnode);
-
-    for (unsigned int i=0; i<i_max; i++)
-    {
-      if (task_data_arr[i].bb_list[0] == cnode_num)
-      {
-	// Create the note
-	DptNote dpt_note;
-
-	dpt_note.set_id(i);
-	dpt_note.set_first_bb(task_data_arr[i].bb_list[0]);
-	dpt_note.set_last_bb(task_data_arr[i].bb_list[task_data_arr[i].bb_list_size-1]);
-
-        // Get the 1st instruction in the basic block (BB = CfgNode)
-        Instr *mi_first_nonlabel = first_non_label(cnode);
+  ctx->times.stop(LCU_PH_MATCH);
 
-	set_note(mi_first_nonlabel, k_dpt, dpt_note);
+  ctx->times.start(LCU_PH_NOTES);
 
-	// Examine note
-	DptNote dpt_note_read = get_note(mi_first_nonlabel, k_dpt);
-      }
-    }
-  }
-
-  for (unsigned int i=0; i<cac_task_id_max; i++)
-  {
-    // ldst <entry-num>, <current-task-data>, <next-task-data>, <next-ttsel>, <next-loop-addr>
-    dbg_printf(".dptt\t%d, %d, %d, %d, %d\n",
-            i,
-            TCFG[i].current_taskid,
-	    TCFG[i].next_taskid,
-	    TCFG[i].next_ttsel,
-	    TCFG[i].next_loop_addr);
-  }
+  // Where the notes go; their fields stay in the context tables until the
+  // notes are materialized
+  tcfg_note_ref *notes = (tcfg_note_ref *)ctx->arena.alloc(
+    (3*facts_max + ctx->cac_task_id_max + LoopOverheadInstr_id)*sizeof(tcfg_note_ref));
+  unsigned notes_max = 0;
 
-  for (unsigned int i=0; i<cac_task_id_max; i++)
+  for (unsigned f=0; f<facts_max; f++)
   {
-    // Get the task ID
-    int local_taskid = TCFG[i].current_taskid;
+    CfgNode* cnode = facts[f].cnode;
+    int cnode_num = facts[f].number;
+    int i = facts[f].task;
 
-    // Get the ID for the last BB in the specified task
-    int last_bb_num = task_data_arr[local_taskid].bb_list[task_data_arr[local_taskid].bb_list_size-1];
+    if (i < 0)
+      continue;
 
-    // Get the corresponding CfgNode
-    CfgNode* cnode = get_node(cfg, last_bb_num);
-
-    Instr *mi_last_noncti;
-
-    DpttNote dptt_note;
+    add_note_ref(notes, &notes_max, cnode, TCFG_NOTE_LIX, i);
 
-    dptt_note.set_id(i);
-    dptt_note.set_current_taskid(TCFG[i].current_taskid);
-    dptt_note.set_next_taskid(TCFG[i].next_taskid);
-    dptt_note.set_next_ttsel(TCFG[i].next_ttsel);
-    dptt_note.set_next_loop_addr(TCFG[i].next_loop_addr);
+    // A DptNote on the first instruction of each data-processing task
+    if (ctx->first_bb(i) == cnode_num)
+      add_note_ref(notes, &notes_max, first_non_label(cnode), TCFG_NOTE_DPT, i);
 
-    // Get the last non-cti instruction in the basic block (BB = CfgNode)
-    mi_last_noncti = last_non_cti(cnode);
-
-    set_note(mi_last_noncti, k_dptt, dptt_note);
-
-    // Examine note
-    DpttNote dptt_note_read = get_note(mi_last_noncti, k_dptt);
+    // A LoopNote on the last BB of each bwd task (it contains the
+    // add-cmp-branch pattern)
+    if (ctx->task_data_arr[i].FSMsel == 0 && ctx->last_bb(i) == cnode_num)
+      add_note_ref(notes, &notes_max, last_non_cti(cnode), TCFG_NOTE_LOOP, i);
   }
 
-  for (int i=0; i<=get_max_loop_num(task_data_arr, i_max); i++)
+  // Per-procedure listings, skipped altogether below LCU_LOG_DEBUG
+  if (lcu_log_enabled(LCU_LOG_DEBUG))
   {
-    dbg_printf(".loop\t%d, %d, %d, %d, %d\n",
-            i,
-	    loop_index_arr[i],
-	    loop_initial_arr[i],
-	    loop_step_arr[i],
-	    loop_final_arr[i]);
-  }
+    dbg_printf("\n");
 
-//  int loop_id = 0;
-
-  // Iterate through the nodes of the CFG
-  for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
-  {
-    // Get the current node
-    CfgNode* cnode = get_node(cfg, cfg_nh);
-    int cnode_num = get_number(cnode);
-
-    // Examine note
-    if (has_note(cnode, k_lix))
+    for (unsigned int i=0; i<ctx->i_max; i++)
     {
-    LoopIndexNote lix_note_read = get_note(cnode, k_lix);
-
-    claim(!is_null(lix_note_read));
-
-    // Check if this BB contains the add-cmp-branch pattern of a bwd task
-    // Actually read the task_id and ttsel fields of the LoopIndexNote that is
-    // already attached to this BB
-    int local_task_id = lix_note_read.get_task_id();
-    int local_ttsel   = lix_note_read.get_ttsel();
-    int loop_id       = lix_note_read.get_loop_addr();
-
-    Instr *mi_last_noncti;
+      // dpti <entry-num>, <first-bb-num>, <last-bb-num>
+      dbg_printf(".dpti\t%d, %d, %d\n",
+              i,
+              ctx->first_bb(i),
+	      ctx->last_bb(i));
+    }
 
-    if (local_ttsel == 0)
+    for (unsigned int i=0; i<ctx->cac_task_id_max; i++)
     {
-      // Get the id of the last BB in the task
-      int last_bb_num = task_data_arr[local_task_id].bb_list[task_data_arr[local_task_id].bb_list_size-1];
-
-      if (last_bb_num == cnode_num)
-      {
-	LoopNote loop_note;
-
-	loop_note.set_loop_addr(loop_id);
-	loop_note.set_ixnum(loop_index_arr[loop_id]);
-	loop_note.set_initial(loop_initial_arr[loop_id]);
-	loop_note.set_step(loop_step_arr[loop_id]);
-	loop_note.set_final(loop_final_arr[loop_id]);
-
-        // Get the last non-cti instruction in the basic block (BB = CfgNode)
-	mi_last_noncti = last_non_cti(cnode);
-
-	set_note(mi_last_noncti, k_loop, loop_note);
-
-	// Examine note
-	LoopNote loop_note_read = get_note(mi_last_noncti, k_loop);
-      }
-    }
+      // ldst <entry-num>, <current-task-data>, <next-task-data>, <next-ttsel>, <next-loop-addr>
+      dbg_printf(".dptt\t%d, %d, %d, %d, %d\n",
+              i,
+              ctx->TCFG[i].current_taskid,
+	      ctx->TCFG[i].next_taskid,
+	      ctx->TCFG[i].next_ttsel,
+	      ctx->TCFG[i].next_loop_addr);
     }
   }
 
-  for (int i=0; i<LoopOverheadInstr_id; i++)
+  // A DpttNote on the last non-cti instruction of the task each TCFG entry
+  // leaves
+  for (unsigned int i=0; i<ctx->cac_task_id_max; i++)
   {
-    dbg_printf(".overhead\t%d, %d, %d, %d\n",
-            i,
-	    LoopOverheadInstr[i].bb_num,
-	    LoopOverheadInstr[i].instr_num,
-	    LoopOverheadInstr[i].istate);
+    int last_bb_num = ctx->last_bb(ctx->TCFG[i].current_taskid);
+    CfgNode* cnode = get_node(cfg, last_bb_num);
+
+    add_note_ref(notes, &notes_max, last_non_cti(cnode), TCFG_NOTE_DPTT, i);
   }
 
-  for (int i=0; i<LoopOverheadInstr_id; i++)
+  if (lcu_log_enabled(LCU_LOG_DEBUG))
   {
-    // Get the BB id for the specified overhead instruction
-    int cnode_num = LoopOverheadInstr[i].bb_num;
-
-    // Get the BB
-    CfgNode* cnode = get_node(cfg, cnode_num);
+    for (int i=0; i<=get_max_loop_num(ctx); i++)
+    {
+      dbg_printf(".loop\t%d, %d, %d, %d, %d\n",
+              i,
+	      ctx->loop_index_arr[i],
+	      ctx->loop_initial_arr[i],
+	      ctx->loop_step_arr[i],
+	      ctx->loop_final_arr[i]);
+    }
 
-    if (LoopOverheadInstr[i].bb_num == (unsigned)cnode_num)
+    for (int i=0; i<LoopOverheadInstr_id; i++)
     {
-      unsigned int hk_num=0;
+      dbg_printf(".overhead\t%d, %d, %d, %d\n",
+              i,
+	      ctx->LoopOverheadInstr[i].bb_num,
+	      ctx->LoopOverheadInstr[i].instr_num,
+	      ctx->LoopOverheadInstr[i].istate);
+    }
+  }
 
-      // Iterate through CfgNode cnode (current basic block)
-      for (InstrHandle hk = instrs_start(cnode); hk != instrs_end(cnode); ++hk)
-      {
-        Instr *mk = *hk;
+  // The overhead notes go straight to the recorded instructions
+  for (int i=0; i<LoopOverheadInstr_id; i++)
+    add_note_ref(notes, &notes_max, overhead_instr[i], TCFG_NOTE_OVERHEAD, i);
 
-	if (LoopOverheadInstr[i].instr_num == hk_num)
-	{
-	  OvrhdInstrNote ovhi_note;
+  attach_notes(ctx, notes, notes_max);
 
-	  ovhi_note.set_istate(LoopOverheadInstr[i].istate);
+  ctx->times.stop(LCU_PH_NOTES);
 
-	  set_note(mk, k_overhead, ovhi_note);
+  ctx->overhead_max = LoopOverheadInstr_id;
+  report_unit(ctx, LoopOverheadInstr_id);
 
-	  // Examine note
-	  OvrhdInstrNote ovhi_note_read = get_note(mk, k_overhead);
-	}
+  if (sidecar.is_open())
+    sidecar.add(ctx);
 
-	hk_num++;
-      }
-    }
+  if (cache.is_open() && !ctx->cached)
+  {
+    ctx->times.start(LCU_PH_CACHE);
+    cache.store(ctx);
+    ctx->times.stop(LCU_PH_CACHE);
   }
 
-
-  procedure_count++;
 }   /*** END OF tcfggen.cpp */
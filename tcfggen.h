@@ -20,39 +20,123 @@
 #pragma interface "tcfggen/tcfggen.h"
 #endif
 
+#include <pthread.h>
+
 #include <machine/machine.h>
 
-#define DEBUG
+#include "tcfggen/lcuctx.h"
+#include "tcfggen/lcusink.h"
+#include "tcfggen/lcubundle.h"
+#include "tcfggen/lcuside.h"
+#include "tcfggen/lcucache.h"
+#include "tcfggen/lcutime.h"
+#include "tcfggen/lculog.h"
 
-#ifdef DEBUG
-#  include <stdio.h>
-#  define dbg_printf(args...) fprintf (stderr, "DBG: " args)
-#  define _d_(arg) arg
-#else
-#  define dbg_printf(args...)
-#  define _d_(arg)
-#endif
+// Contents of loop_results.txt (-report)
+enum {
+  LCU_REPORT_NONE = 0,          // no report file
+  LCU_REPORT_SUMMARY,           // a summary line per procedure
+  LCU_REPORT_FULL,              // dominance and loop dumps plus the summary
+  LCU_REPORT_COMPACT            // key=value lines, for scripts
+};
+
+class LcuWorkPool;
+class LcuLoopFinder;
+struct tcfg_note_ref_t;
+class LcuStage;
 
 class TcfgGen {
   public:
-    TcfgGen() { }
+    TcfgGen();
+    ~TcfgGen();
 
-    void initialize() { }
+    void initialize();
     void do_opt_unit(OptUnit*);
-    void finalize() { }
+    void finalize();
+
+    // deferred processing of a batch of units on a work pool (-j N)
+    void prepare_opt_unit(OptUnit*);
+    void analyze_pending();
+    unsigned pending_size() const       { return pending_units.size(); }
+    OptUnit *get_pending_unit(unsigned i) const { return pending_units[i]; }
+    void commit_pending(unsigned i);
+    void clear_pending();
 
     // set pass options
     void set_gen_lut_file(bool sl)      { gen_lut_file = sl; }
     void set_gen_vcg_file(bool sl)      { gen_vcg_file = sl; }
     void set_gen_fsm_file(bool sl)      { gen_fsm_file = sl; }
     void set_gen_cac_file(bool sl)      { gen_cac_file = sl; }
+    void set_num_threads(int n)         { num_threads = (n > 0) ? n : 1; }
+    void set_bundle_file(IdString s)    { bundle_file_name = s; }
+    void set_reproducible(bool sl)      { reproducible = sl; }
+    void set_emit_queue(int n)          { emit_queue = (n > 0) ? n : 0; }
+    void set_trace_file(IdString s)     { trace_file_name = s; }
+    void set_sidecar_file(IdString s)   { sidecar_file_name = s; }
+    void set_cache_dir(IdString s)      { cache_dir_name = s; }
+    void set_report(int r)              { report = r; }
+    void set_validate_loops(bool sl)    { validate_loops = sl; }
+    void set_compact_notes(bool sl)     { compact_notes = sl; }
+    int get_num_threads() const         { return num_threads; }
 
   protected:
+    void prepare_unit(OptUnit*, LcuContext*);
+    void commit_unit(OptUnit*, LcuContext*);
+    LcuContext *acquire_context();
+    void release_context(LcuContext*);
+    void store_artifacts(LcuContext*);
+    void emit_unit(LcuContext*);
+    void hand_off(LcuContext*);
+    static void emit_unit_job(void *self, void *ctx);
+    void record_times(LcuContext*);
+    void print_times();
+    void print_cache_stats();
+    void report_unit(LcuContext*, int num_overhead);
+    bool cfg_may_simplify(Cfg*);
+    void validate_unit_loops(LcuContext*, Cfg*, const LcuLoopFinder&);
+    void attach_notes(LcuContext*, const struct tcfg_note_ref_t*, unsigned);
+
     bool gen_lut_file;
     bool gen_vcg_file;
     bool gen_fsm_file;
     bool gen_cac_file;
+    int num_threads;
+    bool reproducible;
+    int emit_queue;             // -emit_queue, 0 for emission in line
+    int report;                 // LCU_REPORT_*
+    bool validate_loops;        // -validate_loops
+    bool compact_notes;         // -compact_notes
+    unsigned loop_mismatches;   // units whose loop analysis differed
+    unsigned simplify_mismatches; // units the simplify skip missed
+
+    int procedure_count;        // units processed so far in this run
+    LcuSink loop_report;        // loop_results.txt
+    IdString bundle_file_name;  // -bundle, empty for one file per artifact
+    LcuBundleWriter bundle;
+    IdString trace_file_name;   // -trace, empty for no timeline
+    LcuTrace trace;
+    IdString sidecar_file_name; // -sidecar, empty for no sidecar
+    LcuSidecarWriter sidecar;
+    IdString cache_dir_name;    // -cache_dir, empty for no analysis cache
+    LcuAnalysisCache cache;
 
+    // Phase times per unit (in completion order) and for the whole run
+    struct unit_times_t {
+      char *name;
+      LcuTimes times;
+    };
+    pthread_mutex_t times_lock;
+    vector<unit_times_t> unit_times;
+    LcuTimes run_times;
+    LcuWorkPool *work_pool;
+    LcuStage *emit_stage;
+    pthread_mutex_t context_lock;       // guards free_contexts
+    vector<LcuContext*> free_contexts;
+    vector<OptUnit*> pending_units;
+    vector<LcuContext*> pending_contexts;
+    vector<char> node_seen;             // cfg_may_simplify() worklist
+    vector<CfgNode*> node_work;
+    vector<IdString> task_enc_ids;      // per task, in attach_notes()
 };
 
 #endif /* TCFGGEN_TCFGGEN_H */
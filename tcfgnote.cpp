@@ -0,0 +1,127 @@
+/* file "tcfggen/tcfgnote.cpp" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#include <stdio.h>
+
+#include <machine/copyright.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma implementation "tcfggen/tcfgnote.h"
+#endif
+
+#include <machine/machine.h>
+
+#include "tcfggen/tcfgnote.h"
+
+#ifdef USE_DMALLOC
+#include <dmalloc.h>
+#define new D_NEW
+#endif
+
+#define FIELD_MASK(bits)   ((1L << (bits)) - 1)
+
+#define FWDSEL_SHIFT       TCFG_TTSEL_BITS
+#define LOOP_ADDR_SHIFT    (FWDSEL_SHIFT + TCFG_FWDSEL_BITS)
+#define TASK_ID_SHIFT      (LOOP_ADDR_SHIFT + TCFG_LOOP_ADDR_BITS)
+
+
+bool TcfgTask::fits(int task_id, int fwdsel, int loop_addr)
+{
+    return task_id >= 0 && task_id <= FIELD_MASK(TCFG_TASK_ID_BITS) &&
+           fwdsel >= 0 && fwdsel <= FIELD_MASK(TCFG_FWDSEL_BITS) &&
+           loop_addr >= 0 && loop_addr <= FIELD_MASK(TCFG_LOOP_ADDR_BITS);
+}
+
+long TcfgTask::pack() const
+{
+    return ((long)(ttsel != 0)) |
+           ((long)fwdsel << FWDSEL_SHIFT) |
+           ((long)loop_addr << LOOP_ADDR_SHIFT) |
+           ((long)task_id << TASK_ID_SHIFT);
+}
+
+void TcfgTask::unpack(long packed)
+{
+    ttsel = packed & FIELD_MASK(TCFG_TTSEL_BITS);
+    fwdsel = (packed >> FWDSEL_SHIFT) & FIELD_MASK(TCFG_FWDSEL_BITS);
+    loop_addr = (packed >> LOOP_ADDR_SHIFT) & FIELD_MASK(TCFG_LOOP_ADDR_BITS);
+    task_id = (packed >> TASK_ID_SHIFT) & FIELD_MASK(TCFG_TASK_ID_BITS);
+}
+
+char *TcfgTask::sprint_enc(char *buf) const
+{
+    if (ttsel == 0)
+      sprintf(buf, "bwd%d", loop_addr);
+    else
+      sprintf(buf, "fwd%d(%d)", loop_addr, fwdsel);
+    return buf;
+}
+
+
+void TcfgTaskMap::read(Cfg *cfg)
+{
+    tasks.clear();
+    bb_task.assign(nodes_size(cfg), -1);
+
+    for (CfgNodeHandle cfg_nh=nodes_start(cfg); cfg_nh!=nodes_end(cfg); ++cfg_nh)
+    {
+      CfgNode* cnode = get_node(cfg, cfg_nh);
+      TcfgTask task;
+
+      if (has_note(cnode, k_tcfg_task))
+      {
+        TaskNote task_note = get_note(cnode, k_tcfg_task);
+
+        task.unpack(task_note.get_packed());
+        task.ixnum = task_note.get_ixnum();
+      }
+      else if (has_note(cnode, k_lix))
+      {
+        LoopIndexNote lix_note = get_note(cnode, k_lix);
+
+        task.task_id = lix_note.get_task_id();
+        task.ttsel = lix_note.get_ttsel();
+        task.fwdsel = lix_note.get_fwdsel();
+        task.loop_addr = lix_note.get_loop_addr();
+        task.ixnum = lix_note.get_ixnum();
+      }
+      else
+      {
+        // The task of a TaskRefNote is filled in by its first BB
+        if (has_note(cnode, k_tcfg_task_ref))
+        {
+          TaskRefNote ref_note = get_note(cnode, k_tcfg_task_ref);
+          bb_task[get_number(cnode)] = ref_note.get_task_id();
+        }
+        continue;
+      }
+
+      if ((unsigned)task.task_id >= tasks.size())
+      {
+        TcfgTask none = { -1, 0, 0, 0, 0 };
+        tasks.resize(task.task_id+1, none);
+      }
+      tasks[task.task_id] = task;
+      bb_task[get_number(cnode)] = task.task_id;
+    }
+}
+
+const TcfgTask *TcfgTaskMap::get_task(CfgNode *cnode) const
+{
+    unsigned n = get_number(cnode);
+    int id = (n < bb_task.size()) ? bb_task[n] : -1;
+
+    if (id < 0 || (unsigned)id >= tasks.size() || tasks[id].task_id != id)
+      return NULL;
+    return &tasks[id];
+}
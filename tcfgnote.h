@@ -0,0 +1,134 @@
+/* file "tcfggen/tcfgnote.h" */
+/*
+ *     Copyright (c) 2003, 2004, 2005, 2006, 2007, 2008, 2009, 2010,
+ *                   2011, 2012, 2013, 2014, 2015, 2016 Nikolaos Kavvadias
+ *
+ *     This software was written by Nikolaos Kavvadias, Ph.D. candidate
+ *     at the Physics Department, Aristotle University of Thessaloniki,
+ *     Greece (at the time).
+ *
+ *     This software is provided under the terms described in
+ *     the "machine/copyright.h" include file.
+ */
+
+#ifndef TCFGGEN_TCFGNOTE_H
+#define TCFGGEN_TCFGNOTE_H
+
+#include <machine/copyright.h>
+
+#ifdef USE_PRAGMA_INTERFACE
+#pragma interface "tcfggen/tcfgnote.h"
+#endif
+
+#include <machine/machine.h>
+
+
+/*
+ * Task notes of the BBs in the output CFG, for the passes that follow
+ * tcfggen. By default every BB of a task carries a LoopIndexNote ("ix").
+ * With -compact_notes the first BB of a task carries a TaskNote
+ * ("tcfg_task") instead, and each further BB a TaskRefNote ("tcfg_task_ref")
+ * holding just the task id. TcfgTaskMap reads either form.
+ */
+
+extern IdString k_lix, k_tcfg_task, k_tcfg_task_ref;
+
+/*
+ * LoopIndexNote = loop index and task encoding note
+ * Attach to each BB of a task
+ */
+class LoopIndexNote : public Note {
+ public:
+    LoopIndexNote() : Note(note_list_any()) { }
+    LoopIndexNote(const LoopIndexNote &other) : Note(other) { }
+    LoopIndexNote(const Note &note) : Note(note) { }
+
+    int get_ixnum() const               { return _get_c_long(0); }
+    void set_ixnum(int ixnum)           { _replace(0, ixnum); }
+    IdString get_ixnum_str() const      { return _get_string(1); }
+    void set_ixnum_str(IdString lix_id) { _replace(1, lix_id); }
+    int get_task_id() const             { return _get_c_long(2); }
+    void set_task_id(int task_id)       { _replace(2, task_id); }
+    int get_ttsel() const               { return _get_c_long(3); }
+    void set_ttsel(int ttsel)           { _replace(3, ttsel); }
+    int get_fwdsel() const              { return _get_c_long(4); }
+    void set_fwdsel(int fwdsel)         { _replace(4, fwdsel); }
+    int get_loop_addr() const           { return _get_c_long(5); }
+    void set_loop_addr(int loop_addr)   { _replace(5, loop_addr); }
+    IdString get_task_enc() const       { return _get_string(6); }
+    void set_task_enc(IdString task_id) { _replace(6, task_id); }
+};
+
+// Packed task encoding of a TaskNote, from the least significant bit: the
+// task type (ttsel: 0 for bwd, 1 for fwd), fwdsel, loop address and task id.
+// 31 bits in all, so that it fits a long everywhere.
+#define TCFG_TTSEL_BITS         1
+#define TCFG_FWDSEL_BITS        8
+#define TCFG_LOOP_ADDR_BITS     10
+#define TCFG_TASK_ID_BITS       12
+
+// The decoded task encoding of a BB
+struct TcfgTask {
+    int task_id;
+    int ttsel;
+    int fwdsel;
+    int loop_addr;
+    int ixnum;                  // loop index register
+
+    static bool fits(int task_id, int fwdsel, int loop_addr);
+    long pack() const;
+    void unpack(long packed);
+
+    // "bwd<loop_addr>" or "fwd<loop_addr>(<fwdsel>)", as in the task_enc
+    // field of the LoopIndexNote; buf needs 32 characters
+    char *sprint_enc(char *buf) const;
+};
+
+/*
+ * TaskNote = packed task encoding and loop index register
+ * Attach to the first BB of a task (-compact_notes)
+ */
+class TaskNote : public Note {
+ public:
+    TaskNote() : Note(note_list_any()) { }
+    TaskNote(const TaskNote &other) : Note(other) { }
+    TaskNote(const Note &note) : Note(note) { }
+
+    long get_packed() const             { return _get_c_long(0); }
+    void set_packed(long packed)        { _replace(0, packed); }
+    int get_ixnum() const               { return _get_c_long(1); }
+    void set_ixnum(int ixnum)           { _replace(1, ixnum); }
+};
+
+/*
+ * TaskRefNote = task id of a BB
+ * Attach to the BBs of a task but the first (-compact_notes)
+ */
+class TaskRefNote : public Note {
+ public:
+    TaskRefNote() : Note(note_list_any()) { }
+    TaskRefNote(const TaskRefNote &other) : Note(other) { }
+    TaskRefNote(const Note &note) : Note(note) { }
+
+    int get_task_id() const             { return _get_c_long(0); }
+    void set_task_id(int task_id)       { _replace(0, task_id); }
+};
+
+/*
+ * TcfgTaskMap = the task of every BB of a CFG written by tcfggen, decoded
+ * once from the compact or the full notes.
+ */
+class TcfgTaskMap {
+  public:
+    void read(Cfg *cfg);
+
+    // NULL for a BB in no task
+    const TcfgTask *get_task(CfgNode *cnode) const;
+
+  protected:
+    vector<TcfgTask> tasks;             // by task id
+    vector<int> bb_task;                // by BB number, -1 if in no task
+};
+
+
+#endif /* TCFGGEN_TCFGNOTE_H */